@@ -1,3 +1,10 @@
 D:\Tools/VulkanSDK/1.3.236.0/Bin/glslangValidator.exe -V shader.vert
 D:\Tools/VulkanSDK/1.3.236.0/Bin/glslangValidator.exe -V shader.frag
+D:\Tools/VulkanSDK/1.3.236.0/Bin/glslangValidator.exe -V rgb_to_yuv.comp -o rgb_to_yuv.spv
+rem compile_shaders.bat -O: optimize (performance recipe) and strip debug info, renderer does the same at load time if built with SPIRV-Tools
+if "%1"=="-O" (
+D:\Tools/VulkanSDK/1.3.236.0/Bin/spirv-opt.exe -O --strip-debug vert.spv -o vert.spv
+D:\Tools/VulkanSDK/1.3.236.0/Bin/spirv-opt.exe -O --strip-debug frag.spv -o frag.spv
+D:\Tools/VulkanSDK/1.3.236.0/Bin/spirv-opt.exe -O --strip-debug rgb_to_yuv.spv -o rgb_to_yuv.spv
+)
 pause
\ No newline at end of file
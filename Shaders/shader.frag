@@ -4,7 +4,15 @@ layout (location = 0) in vec3 fragColor;
 
 layout (location = 0) out vec4 outColor; // Final output color (must also have location)
 
+// Specialization constant: set per pipeline variant, branch is folded away when pipeline is built
+layout (constant_id = 0) const bool GRAYSCALE = false;
+
 void main()
 {
-    outColor = vec4(fragColor, 1.0f);
-}
\ No newline at end of file
+    vec3 color = fragColor;
+    if (GRAYSCALE)
+    {
+        color = vec3(dot(color, vec3(0.299f, 0.587f, 0.114f)));
+    }
+    outColor = vec4(color, 1.0f);
+}
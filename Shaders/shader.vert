@@ -5,9 +5,23 @@ layout (location = 1) in vec3 vertexColor;
 
 layout (location = 0) out vec3 fragColor;
 
+// Per-frame scene uniforms (SceneUniforms), dynamic offset picks this frame's slice of the ring
+layout (set = 0, binding = 0) uniform SceneData
+{
+    mat4 view;
+    mat4 projection;
+    float time;
+} scene;
+
+// Per-draw object data (ObjectPushConstants), pushed before each draw
+layout (push_constant) uniform ObjectData
+{
+    mat4 model;
+} object;
+
 void main()
 {
-    gl_Position = vec4(vertexPosition, 1.0f);
+    gl_Position = scene.projection * scene.view * object.model * vec4(vertexPosition, 1.0f);
 
     fragColor = vertexColor;
 }
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include "CommandEncoder.h"
+
+#include <cstring>
+
+CommandEncoder::CommandEncoder()
+{
+}
+
+CommandEncoder::CommandEncoder(VkCommandBuffer newCommandBuffer, const DynamicStateFunctions* newDynamicStateFunctions)
+{
+	commandBuffer = newCommandBuffer;
+	dynamicStateFunctions = newDynamicStateFunctions;
+	InvalidateState();
+}
+
+void CommandEncoder::Begin(const VkCommandBufferBeginInfo& beginInfo)
+{
+	// Fresh command buffer has no state bound at all
+	InvalidateState();
+
+	VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to start recording a Command Buffer!");
+	}
+}
+
+void CommandEncoder::End()
+{
+	VkResult result = vkEndCommandBuffer(commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to end recording a Command Buffer!");
+	}
+}
+
+void CommandEncoder::BeginRenderPass(const VkRenderPassBeginInfo& renderPassBeginInfo, VkSubpassContents contents)
+{
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, contents);
+}
+
+void CommandEncoder::EndRenderPass()
+{
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+void CommandEncoder::BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+	// Only graphics bind point is tracked, compute pipelines always go to the driver
+	bool tracked = bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS;
+	if (!Issue(tracked && pipeline == boundPipeline))
+	{
+		return;
+	}
+
+	vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+	if (tracked)
+	{
+		boundPipeline = pipeline;
+
+		// Extended dynamic state only survives a bind if new pipeline has the same state dynamic, which encoder can't see,
+		// so it is set again after every pipeline change (viewport and scissor are dynamic in every pipeline, they stay)
+		dynamicStateValid = 0;
+	}
+}
+
+void CommandEncoder::BindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets)
+{
+	bool tracked = firstBinding + bindingCount <= MAX_TRACKED_VERTEX_BINDINGS;
+
+	// Redundant only if every binding in range already holds the same buffer at the same offset
+	bool redundant = tracked;
+	for (uint32_t i = 0; redundant && i < bindingCount; i++)
+	{
+		const VertexBinding& binding = boundVertexBuffers[firstBinding + i];
+		redundant = binding.buffer == buffers[i] && binding.offset == offsets[i];
+	}
+
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, buffers, offsets);
+	for (uint32_t i = 0; i < bindingCount && firstBinding + i < MAX_TRACKED_VERTEX_BINDINGS; i++)
+	{
+		boundVertexBuffers[firstBinding + i].buffer = buffers[i];
+		boundVertexBuffers[firstBinding + i].offset = offsets[i];
+	}
+}
+
+void CommandEncoder::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+	bool redundant = boundIndexBuffer.buffer == buffer && boundIndexBuffer.offset == offset && boundIndexBuffer.indexType == indexType;
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+	boundIndexBuffer.buffer = buffer;
+	boundIndexBuffer.offset = offset;
+	boundIndexBuffer.indexType = indexType;
+}
+
+void CommandEncoder::BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount, const VkDescriptorSet* sets,
+	uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets)
+{
+	bool tracked = bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && firstSet + setCount <= MAX_TRACKED_DESCRIPTOR_SETS;
+
+	// Redundant only if exactly the same call was made before (same layout, sets and dynamic offsets)
+	// Dynamic offsets can't be split per set without knowing the layout, so compare them for whole call
+	bool redundant = tracked && setCount > 0
+		&& boundDescriptorSets[firstSet].firstSet == firstSet
+		&& boundDescriptorSets[firstSet].setCount == setCount
+		&& boundDescriptorSets[firstSet].dynamicOffsets.size() == dynamicOffsetCount
+		&& (dynamicOffsetCount == 0 || memcmp(boundDescriptorSets[firstSet].dynamicOffsets.data(), dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t)) == 0);
+	for (uint32_t i = 0; redundant && i < setCount; i++)
+	{
+		const DescriptorBinding& binding = boundDescriptorSets[firstSet + i];
+		redundant = binding.layout == layout && binding.set == sets[i];
+	}
+
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+	if (!tracked)
+	{
+		// Untracked call may have overwritten tracked sets, so forget them
+		for (DescriptorBinding& binding : boundDescriptorSets)
+		{
+			binding = DescriptorBinding();
+		}
+		return;
+	}
+
+	// Binding with an incompatible layout disturbs sets bound with the old one (above firstSet always, below too if
+	// layouts differ for them); compatibility is not known here, so a different layout handle counts as incompatible
+	for (DescriptorBinding& binding : boundDescriptorSets)
+	{
+		if (binding.layout != layout)
+		{
+			binding = DescriptorBinding();
+		}
+	}
+
+	// Any earlier call that overlaps this one is no longer valid as a whole
+	for (DescriptorBinding& binding : boundDescriptorSets)
+	{
+		if (binding.setCount > 0 && binding.firstSet < firstSet + setCount && firstSet < binding.firstSet + binding.setCount)
+		{
+			binding.setCount = 0;
+			binding.dynamicOffsets.clear();
+		}
+	}
+
+	for (uint32_t i = 0; i < setCount; i++)
+	{
+		DescriptorBinding& binding = boundDescriptorSets[firstSet + i];
+		binding.layout = layout;
+		binding.set = sets[i];
+		binding.firstSet = firstSet;
+		binding.setCount = setCount;
+		binding.dynamicOffsets.clear();
+	}
+	boundDescriptorSets[firstSet].dynamicOffsets.assign(dynamicOffsets, dynamicOffsets + dynamicOffsetCount);
+}
+
+void CommandEncoder::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values)
+{
+	bool tracked = offset + size <= MAX_TRACKED_PUSH_CONSTANT_SIZE;
+
+	// Pushes made with a different layout don't count
+	if (tracked && layout != pushConstantLayout)
+	{
+		pushConstantStages.fill(0);
+		pushConstantLayout = layout;
+	}
+
+	// Redundant only if every byte was already pushed for the same stages with the same value
+	bool redundant = tracked && memcmp(&pushConstantData[offset], values, size) == 0;
+	for (uint32_t i = offset; redundant && i < offset + size; i++)
+	{
+		redundant = pushConstantStages[i] == stageFlags;
+	}
+
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, values);
+	if (tracked)
+	{
+		memcpy(&pushConstantData[offset], values, size);
+		for (uint32_t i = offset; i < offset + size; i++)
+		{
+			pushConstantStages[i] = stageFlags;
+		}
+	}
+}
+
+void CommandEncoder::SetViewport(const VkViewport& viewport)
+{
+	bool redundant = viewportValid && memcmp(&boundViewport, &viewport, sizeof(VkViewport)) == 0;
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	boundViewport = viewport;
+	viewportValid = true;
+}
+
+void CommandEncoder::SetScissor(const VkRect2D& scissor)
+{
+	bool redundant = scissorValid && memcmp(&boundScissor, &scissor, sizeof(VkRect2D)) == 0;
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	boundScissor = scissor;
+	scissorValid = true;
+}
+
+void CommandEncoder::SetCullMode(VkCullModeFlags cullMode)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_CULL_MODE) && boundCullMode == cullMode))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setCullMode(commandBuffer, cullMode);
+	boundCullMode = cullMode;
+	dynamicStateValid |= DYNAMIC_CULL_MODE;
+}
+
+void CommandEncoder::SetFrontFace(VkFrontFace frontFace)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_FRONT_FACE) && boundFrontFace == frontFace))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setFrontFace(commandBuffer, frontFace);
+	boundFrontFace = frontFace;
+	dynamicStateValid |= DYNAMIC_FRONT_FACE;
+}
+
+void CommandEncoder::SetPrimitiveTopology(VkPrimitiveTopology topology)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_TOPOLOGY) && boundTopology == topology))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setPrimitiveTopology(commandBuffer, topology);
+	boundTopology = topology;
+	dynamicStateValid |= DYNAMIC_TOPOLOGY;
+}
+
+void CommandEncoder::SetPrimitiveRestartEnable(VkBool32 enable)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_PRIMITIVE_RESTART) && boundPrimitiveRestart == enable))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setPrimitiveRestartEnable(commandBuffer, enable);
+	boundPrimitiveRestart = enable;
+	dynamicStateValid |= DYNAMIC_PRIMITIVE_RESTART;
+}
+
+void CommandEncoder::SetPolygonMode(VkPolygonMode polygonMode)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_POLYGON_MODE) && boundPolygonMode == polygonMode))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setPolygonMode(commandBuffer, polygonMode);
+	boundPolygonMode = polygonMode;
+	dynamicStateValid |= DYNAMIC_POLYGON_MODE;
+}
+
+void CommandEncoder::SetColorBlendEnable(VkBool32 enable)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_BLEND_ENABLE) && boundBlendEnable == enable))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setColorBlendEnable(commandBuffer, 0, 1, &enable);
+	boundBlendEnable = enable;
+	dynamicStateValid |= DYNAMIC_BLEND_ENABLE;
+}
+
+void CommandEncoder::SetColorBlendEquation(const VkColorBlendEquationEXT& equation)
+{
+	bool redundant = (dynamicStateValid & DYNAMIC_BLEND_EQUATION) && memcmp(&boundBlendEquation, &equation, sizeof(VkColorBlendEquationEXT)) == 0;
+	if (!Issue(redundant))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setColorBlendEquation(commandBuffer, 0, 1, &equation);
+	boundBlendEquation = equation;
+	dynamicStateValid |= DYNAMIC_BLEND_EQUATION;
+}
+
+void CommandEncoder::SetColorWriteMask(VkColorComponentFlags writeMask)
+{
+	if (!Issue((dynamicStateValid & DYNAMIC_WRITE_MASK) && boundWriteMask == writeMask))
+	{
+		return;
+	}
+
+	dynamicStateFunctions->setColorWriteMask(commandBuffer, 0, 1, &writeMask);
+	boundWriteMask = writeMask;
+	dynamicStateValid |= DYNAMIC_WRITE_MASK;
+}
+
+void CommandEncoder::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+	stats.drawCalls++;
+}
+
+void CommandEncoder::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+	vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	stats.drawCalls++;
+}
+
+void CommandEncoder::InvalidateState()
+{
+	boundPipeline = VK_NULL_HANDLE;
+	boundVertexBuffers.fill(VertexBinding());
+	boundIndexBuffer.buffer = VK_NULL_HANDLE;
+	boundIndexBuffer.offset = 0;
+	boundIndexBuffer.indexType = VK_INDEX_TYPE_UINT16;
+	for (DescriptorBinding& binding : boundDescriptorSets)
+	{
+		binding = DescriptorBinding();
+	}
+	pushConstantLayout = VK_NULL_HANDLE;
+	pushConstantStages.fill(0);
+	viewportValid = false;
+	scissorValid = false;
+	dynamicStateValid = 0;
+}
+
+VkCommandBuffer CommandEncoder::GetCommandBuffer()
+{
+	return commandBuffer;
+}
+
+EncoderStats CommandEncoder::GetStats()
+{
+	return stats;
+}
+
+CommandEncoder::~CommandEncoder()
+{
+}
+
+bool CommandEncoder::Issue(bool redundant)
+{
+	// Count the call and tell caller whether it has to reach the driver
+	if (redundant)
+	{
+		stats.bindsSkipped++;
+		return false;
+	}
+
+	stats.bindsIssued++;
+	return true;
+}
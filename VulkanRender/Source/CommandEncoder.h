@@ -0,0 +1,155 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <array>
+
+// Max vertex buffer bindings the encoder keeps track of (binds above this always go to the driver)
+const uint32_t MAX_TRACKED_VERTEX_BINDINGS = 16;
+// Max descriptor sets the encoder keeps track of
+const uint32_t MAX_TRACKED_DESCRIPTOR_SETS = 8;
+// Max push constant bytes the encoder shadows (128 bytes is the minimum guaranteed by spec)
+const uint32_t MAX_TRACKED_PUSH_CONSTANT_SIZE = 256;
+
+// Counters of state changes passed through (issued) or dropped (skipped) by encoder
+struct EncoderStats
+{
+	uint32_t bindsIssued = 0;			// State calls that reached the driver
+	uint32_t bindsSkipped = 0;			// State calls that were redundant and dropped
+	uint32_t drawCalls = 0;				// Draw commands recorded
+
+	EncoderStats& operator+=(const EncoderStats& other)
+	{
+		bindsIssued += other.bindsIssued;
+		bindsSkipped += other.bindsSkipped;
+		drawCalls += other.drawCalls;
+		return *this;
+	}
+};
+
+// Extended dynamic state entry points (extension functions, loaded from device; nullptr if not enabled)
+struct DynamicStateFunctions
+{
+	PFN_vkCmdSetCullModeEXT setCullMode = nullptr;
+	PFN_vkCmdSetFrontFaceEXT setFrontFace = nullptr;
+	PFN_vkCmdSetPrimitiveTopologyEXT setPrimitiveTopology = nullptr;
+	PFN_vkCmdSetPrimitiveRestartEnableEXT setPrimitiveRestartEnable = nullptr;
+	PFN_vkCmdSetPolygonModeEXT setPolygonMode = nullptr;
+	PFN_vkCmdSetColorBlendEnableEXT setColorBlendEnable = nullptr;
+	PFN_vkCmdSetColorBlendEquationEXT setColorBlendEquation = nullptr;
+	PFN_vkCmdSetColorWriteMaskEXT setColorWriteMask = nullptr;
+};
+
+// Thin layer over VkCommandBuffer, remembers currently bound state and drops binds that would change nothing
+class CommandEncoder
+{
+public:
+	CommandEncoder();
+	CommandEncoder(VkCommandBuffer newCommandBuffer, const DynamicStateFunctions* newDynamicStateFunctions = nullptr);
+
+	// - Recording
+	void Begin(const VkCommandBufferBeginInfo& beginInfo);
+	void End();
+	void BeginRenderPass(const VkRenderPassBeginInfo& renderPassBeginInfo, VkSubpassContents contents);
+	void EndRenderPass();
+
+	// - State
+	void BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+	void BindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets);
+	void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	void BindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount, const VkDescriptorSet* sets,
+		uint32_t dynamicOffsetCount = 0, const uint32_t* dynamicOffsets = nullptr);
+	void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values);
+	void SetViewport(const VkViewport& viewport);
+	void SetScissor(const VkRect2D& scissor);
+
+	// - Extended dynamic state (only valid with pipelines made with matching VK_DYNAMIC_STATE_*, colour attachment 0 only)
+	void SetCullMode(VkCullModeFlags cullMode);
+	void SetFrontFace(VkFrontFace frontFace);
+	void SetPrimitiveTopology(VkPrimitiveTopology topology);
+	void SetPrimitiveRestartEnable(VkBool32 enable);
+	void SetPolygonMode(VkPolygonMode polygonMode);
+	void SetColorBlendEnable(VkBool32 enable);
+	void SetColorBlendEquation(const VkColorBlendEquationEXT& equation);
+	void SetColorWriteMask(VkColorComponentFlags writeMask);
+
+	// - Draw
+	void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+	void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+
+	// Forget all tracked state (next bind of everything will be issued)
+	void InvalidateState();
+
+	VkCommandBuffer GetCommandBuffer();
+	EncoderStats GetStats();
+
+	~CommandEncoder();
+
+private:
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	const DynamicStateFunctions* dynamicStateFunctions = nullptr;
+	EncoderStats stats;
+
+	// Currently bound state
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+
+	struct VertexBinding
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+	};
+	std::array<VertexBinding, MAX_TRACKED_VERTEX_BINDINGS> boundVertexBuffers;
+
+	struct
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+	} boundIndexBuffer;
+
+	struct DescriptorBinding
+	{
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		uint32_t firstSet = 0;							// First set of the call this set was bound by
+		uint32_t setCount = 0;							// Number of sets bound by that call
+		std::vector<uint32_t> dynamicOffsets;			// Dynamic offsets of that call (kept on first set of call only)
+	};
+	std::array<DescriptorBinding, MAX_TRACKED_DESCRIPTOR_SETS> boundDescriptorSets;
+
+	VkPipelineLayout pushConstantLayout = VK_NULL_HANDLE;
+	std::array<uint8_t, MAX_TRACKED_PUSH_CONSTANT_SIZE> pushConstantData = {};
+	std::array<VkShaderStageFlags, MAX_TRACKED_PUSH_CONSTANT_SIZE> pushConstantStages = {};	// Stages each byte was pushed for (0 = never pushed)
+
+	bool viewportValid = false;
+	VkViewport boundViewport = {};
+	bool scissorValid = false;
+	VkRect2D boundScissor = {};
+
+	// Extended dynamic state, bit of DynamicStateBit set once value below is valid (cleared when pipeline changes)
+	enum DynamicStateBit : uint32_t
+	{
+		DYNAMIC_CULL_MODE = 1 << 0,
+		DYNAMIC_FRONT_FACE = 1 << 1,
+		DYNAMIC_TOPOLOGY = 1 << 2,
+		DYNAMIC_PRIMITIVE_RESTART = 1 << 3,
+		DYNAMIC_POLYGON_MODE = 1 << 4,
+		DYNAMIC_BLEND_ENABLE = 1 << 5,
+		DYNAMIC_BLEND_EQUATION = 1 << 6,
+		DYNAMIC_WRITE_MASK = 1 << 7,
+	};
+	uint32_t dynamicStateValid = 0;
+	VkCullModeFlags boundCullMode = 0;
+	VkFrontFace boundFrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	VkPrimitiveTopology boundTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkBool32 boundPrimitiveRestart = VK_FALSE;
+	VkPolygonMode boundPolygonMode = VK_POLYGON_MODE_FILL;
+	VkBool32 boundBlendEnable = VK_FALSE;
+	VkColorBlendEquationEXT boundBlendEquation = {};
+	VkColorComponentFlags boundWriteMask = 0;
+
+	bool Issue(bool redundant);
+};
@@ -0,0 +1,81 @@
+#include "DeletionQueue.h"
+
+DeletionQueue::DeletionQueue()
+{
+}
+
+void DeletionQueue::Init(const std::vector<GpuTimeline*>& newTimelines, const std::vector<ImmediateSubmitter*>& newSubmitters)
+{
+	timelines = newTimelines;
+	submitters = newSubmitters;
+	entries.clear();
+}
+
+void DeletionQueue::Push(const std::function<void()>& destroy)
+{
+	Entry entry;
+	entry.destroy = destroy;
+
+	// Batches still open may use the object, submit them so their values are covered (no-op if nothing recorded)
+	for (ImmediateSubmitter* submitter : submitters)
+	{
+		submitter->Flush();
+	}
+
+	// Work submitted later can't use the object any more, so current last values are enough
+	for (GpuTimeline* timeline : timelines)
+	{
+		entry.timelineValues.push_back(timeline->GetLastSignalValue());
+	}
+
+	entries.push_back(entry);
+}
+
+void DeletionQueue::Collect()
+{
+	// Entries are pushed in submission order, stop at first one GPU has not passed yet
+	while (!entries.empty() && IsReached(entries.front()))
+	{
+		entries.front().destroy();
+		entries.pop_front();
+	}
+}
+
+void DeletionQueue::Flush()
+{
+	if (entries.empty())
+	{
+		return;
+	}
+
+	// Newest entry has highest values, once they are reached everything is
+	const Entry& newest = entries.back();
+	for (size_t i = 0; i < timelines.size(); i++)
+	{
+		timelines[i]->Wait(newest.timelineValues[i]);
+	}
+
+	Collect();
+}
+
+size_t DeletionQueue::GetPendingCount()
+{
+	return entries.size();
+}
+
+DeletionQueue::~DeletionQueue()
+{
+}
+
+bool DeletionQueue::IsReached(const Entry& entry)
+{
+	for (size_t i = 0; i < timelines.size(); i++)
+	{
+		if (!timelines[i]->IsReached(entry.timelineValues[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
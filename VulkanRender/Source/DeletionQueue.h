@@ -0,0 +1,50 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include "GpuTimeline.h"
+#include "ImmediateSubmitter.h"
+
+// Deferred destruction of GPU objects
+// A destroy request is tagged with the last value submitted on every GPU timeline,
+// object is destroyed once GPU passed all of them, so nothing waits for the device to go idle
+// One-shot work recorded but not flushed yet has no timeline value, so submitters are flushed before tagging
+class DeletionQueue
+{
+public:
+	DeletionQueue();
+
+	// Timelines of all queues that can use objects pushed to this queue, and submitters signalling them
+	void Init(const std::vector<GpuTimeline*>& newTimelines, const std::vector<ImmediateSubmitter*>& newSubmitters);
+
+	// Destroy once all work submitted so far has finished
+	void Push(const std::function<void()>& destroy);
+
+	// Destroy everything GPU is done with, never blocks (call once per frame)
+	void Collect();
+
+	// Wait for GPU and destroy everything left (shutdown)
+	void Flush();
+
+	size_t GetPendingCount();
+
+	~DeletionQueue();
+
+private:
+	struct Entry
+	{
+		std::vector<uint64_t> timelineValues;	// One value per timeline, in Init order
+		std::function<void()> destroy;
+	};
+
+	std::vector<GpuTimeline*> timelines;
+	std::vector<ImmediateSubmitter*> submitters;
+	std::deque<Entry> entries;					// Oldest first, values never decrease towards the back
+
+	bool IsReached(const Entry& entry);
+};
@@ -0,0 +1,50 @@
+#include "FramePacket.h"
+
+FramePacketBuffer::FramePacketBuffer()
+{
+}
+
+FramePacket& FramePacketBuffer::BeginWrite()
+{
+	// Write packet is owned by producer, no lock needed
+	return packets[writeIndex];
+}
+
+void FramePacketBuffer::Publish()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Consumer never saw previous ready packet, it is overwritten next
+	if (hasReady)
+	{
+		droppedCount++;
+	}
+
+	std::swap(writeIndex, readyIndex);
+	hasReady = true;
+}
+
+const FramePacket* FramePacketBuffer::AcquireLatest()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Nothing new, keep reading last packet (render can draw it again)
+	if (hasReady)
+	{
+		std::swap(readIndex, readyIndex);
+		hasReady = false;
+		hasRead = true;
+	}
+
+	return hasRead ? &packets[readIndex] : nullptr;
+}
+
+uint64_t FramePacketBuffer::GetDroppedCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return droppedCount;
+}
+
+FramePacketBuffer::~FramePacketBuffer()
+{
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <mutex>
+
+#include "glm/glm.hpp"
+
+// Camera state the frame is rendered from
+struct CameraPacket
+{
+	glm::vec3 position = glm::vec3(0.0f, 0.0f, 2.0f);
+	glm::mat4 view = glm::mat4(1.0f);
+	float fieldOfView = 45.0f;			// Vertical, in degrees (projection is made by renderer, it knows the aspect)
+};
+
+// Object that passed visibility test this frame
+struct ObjectPacket
+{
+	int meshIndex = 0;					// Index in renderer's mesh list
+	int materialIndex = -1;				// Index in renderer's material list (-1 = default pipeline)
+	glm::mat4 transform = glm::mat4(1.0f);
+};
+
+// Everything render thread needs to draw one frame, written by simulation thread
+// Once published it is never changed again, so render thread can read it without locking
+struct FramePacket
+{
+	uint64_t frameNumber = 0;			// Simulation tick the packet was made at
+	double simulationTime = 0.0;		// Seconds since simulation start
+	CameraPacket camera;
+	std::vector<ObjectPacket> visibleObjects;
+};
+
+// Triple buffer of frame packets between one producer (simulation) and one consumer (render) thread
+// Producer always has a free packet to write and consumer always has the newest finished one,
+// so neither has to wait for the other (lock is only held to swap indices)
+class FramePacketBuffer
+{
+public:
+	FramePacketBuffer();
+
+	// Producer: packet to fill in, then Publish it
+	FramePacket& BeginWrite();
+	void Publish();
+
+	// Consumer: newest published packet, unchanged until next call (nullptr if nothing published yet)
+	const FramePacket* AcquireLatest();
+
+	// Packets published but replaced before consumer took them
+	uint64_t GetDroppedCount();
+
+	~FramePacketBuffer();
+
+private:
+	std::array<FramePacket, 3> packets;
+	int writeIndex = 0;					// Packet producer is writing
+	int readyIndex = 1;					// Last published packet
+	int readIndex = 2;					// Packet consumer is reading
+
+	bool hasReady = false;				// readyIndex holds a packet consumer has not taken yet
+	bool hasRead = false;				// Consumer took at least one packet
+	uint64_t droppedCount = 0;
+
+	std::mutex mutex;
+};
@@ -0,0 +1,297 @@
+#include "FrameReadback.h"
+
+FrameReadback::FrameReadback()
+{
+}
+
+void FrameReadback::Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkExtent2D newExtent, VkFormat newFormat, const ReadbackCallback& newCallback)
+{
+	// Tightly packed rows
+	ReadbackLayout imageLayout;
+	imageLayout.width = newExtent.width;
+	imageLayout.height = newExtent.height;
+	imageLayout.format = newFormat;
+	imageLayout.rowLength = newExtent.width;
+	imageLayout.rowCount = newExtent.height;
+	imageLayout.size = (VkDeviceSize)newExtent.width * newExtent.height * 4;
+
+	Init(newPhysicalDevice, newDevice, imageLayout, 0, newCallback);
+}
+
+void FrameReadback::Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, const ReadbackLayout& newLayout, VkBufferUsageFlags extraUsage, const ReadbackCallback& newCallback)
+{
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	layout = newLayout;
+	callback = newCallback;
+
+	// CPU reads whole buffer, so cached memory is much faster than write-combined; fall back to coherent if there is none
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	VkMemoryPropertyFlags cachedProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	bool hasCached = false;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((memoryProperties.memoryTypes[i].propertyFlags & cachedProperties) == cachedProperties)
+		{
+			hasCached = true;
+			break;
+		}
+	}
+	if (!hasCached)
+	{
+		cachedProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	// Coherency comes from memory types buffers actually got (buffer's allowed types decide which one that is)
+	hostCoherent = true;
+	slots.resize(READBACK_RING_SIZE);
+	for (Slot& slot : slots)
+	{
+		uint32_t memoryTypeIndex = 0;
+		createBuffer(physicalDevice, device, layout.size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | extraUsage, cachedProperties, &slot.buffer, &slot.memory, &memoryTypeIndex);
+
+		VkMemoryPropertyFlags memoryFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+		if (!(memoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+		{
+			throw std::runtime_error("Failed to find host visible memory for Readback Buffer!");
+		}
+		if (!(memoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		{
+			hostCoherent = false;
+		}
+
+		// Stays mapped for whole lifetime of buffer
+		VkResult result = vkMapMemory(device, slot.memory, 0, layout.size, 0, &slot.mappedData);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to map Readback Buffer!");
+		}
+	}
+	nextSlot = 0;
+
+	stopWorker = false;
+	worker = std::thread(&FrameReadback::WorkerLoop, this);
+}
+
+bool FrameReadback::IsActive()
+{
+	return !slots.empty();
+}
+
+int FrameReadback::GetSlotCount()
+{
+	return static_cast<int>(slots.size());
+}
+
+VkBuffer FrameReadback::GetSlotBuffer(int slot)
+{
+	return slots[slot].buffer;
+}
+
+int FrameReadback::AcquireSlot()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (slots[nextSlot].state != SlotState::Free)
+		{
+			// Ring is full, drop this frame instead of waiting
+			return -1;
+		}
+		slots[nextSlot].state = SlotState::Recorded;
+	}
+
+	int slot = nextSlot;
+	nextSlot = (nextSlot + 1) % static_cast<int>(slots.size());
+	return slot;
+}
+
+int FrameReadback::RecordCopy(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout)
+{
+	int slot = AcquireSlot();
+	if (slot < 0)
+	{
+		return -1;
+	}
+
+	// Image moves to transfer layout after last write to it (render pass final transition), which already
+	// made it visible to transfer stage; starting at that stage chains this barrier to it
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = imageLayout;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = image;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.bufferOffset = 0;
+	copyRegion.bufferRowLength = 0;							// 0 = tightly packed
+	copyRegion.bufferImageHeight = 0;
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.mipLevel = 0;
+	copyRegion.imageSubresource.baseArrayLayer = 0;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageOffset = { 0, 0, 0 };
+	copyRegion.imageExtent = { layout.width, layout.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slots[slot].buffer, 1, &copyRegion);
+
+	// Image goes back to layout it had (e.g. for presentation), transfer stage is in destination scope so a following copy chains too
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.dstAccessMask = 0;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = imageLayout;
+
+	// Copied data has to be visible to host once timeline is reached
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = slots[slot].buffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+
+	return slot;
+}
+
+void FrameReadback::Submitted(int slot, uint64_t timelineValue, uint64_t frameNumber)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	slots[slot].state = SlotState::InFlight;
+	slots[slot].timelineValue = timelineValue;
+	slots[slot].frameNumber = frameNumber;
+	inFlightSlots.push_back(slot);
+}
+
+void FrameReadback::Collect(GpuTimeline* timeline)
+{
+	// Copies finish in submission order, stop at first one GPU is still working on
+	while (!inFlightSlots.empty() && timeline->IsReached(slots[inFlightSlots.front()].timelineValue))
+	{
+		int slot = inFlightSlots.front();
+		inFlightSlots.pop_front();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			slots[slot].state = SlotState::Processing;
+			workQueue.push_back(slot);
+		}
+		workReady.notify_one();
+	}
+}
+
+void FrameReadback::Destroy()
+{
+	if (slots.empty())
+	{
+		return;
+	}
+
+	// Worker finishes queued frames, then stops
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopWorker = true;
+	}
+	workReady.notify_one();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+
+	for (Slot& slot : slots)
+	{
+		vkUnmapMemory(device, slot.memory);
+		vkDestroyBuffer(device, slot.buffer, nullptr);
+		vkFreeMemory(device, slot.memory, nullptr);
+	}
+	slots.clear();
+	inFlightSlots.clear();
+	workQueue.clear();
+}
+
+void FrameReadback::WritePPM(const std::string& fileName, const ReadbackImage& image)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		printf("Failed to write %s\n", fileName.c_str());
+		return;
+	}
+
+	file << "P6\n" << image.width << " " << image.height << "\n255\n";
+
+	// Swapchain images are often BGRA, PPM is always RGB
+	bool bgra = image.format == VK_FORMAT_B8G8R8A8_UNORM || image.format == VK_FORMAT_B8G8R8A8_SRGB;
+
+	std::vector<uint8_t> row(image.width * 3);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const uint8_t* pixel = image.pixels + (size_t)y * image.rowLength * 4;
+		for (uint32_t x = 0; x < image.width; x++, pixel += 4)
+		{
+			row[x * 3 + 0] = bgra ? pixel[2] : pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = bgra ? pixel[0] : pixel[2];
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+}
+
+FrameReadback::~FrameReadback()
+{
+}
+
+void FrameReadback::WorkerLoop()
+{
+	while (true)
+	{
+		int slot;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [this]() { return stopWorker || !workQueue.empty(); });
+			if (workQueue.empty())
+			{
+				return;
+			}
+			slot = workQueue.front();
+			workQueue.pop_front();
+		}
+
+		// Make GPU writes visible to CPU caches if memory is not coherent
+		if (!hostCoherent)
+		{
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = slots[slot].memory;
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges(device, 1, &range);
+		}
+
+		ReadbackImage image;
+		image.frameNumber = slots[slot].frameNumber;
+		image.width = layout.width;
+		image.height = layout.height;
+		image.format = layout.format;
+		image.rowLength = layout.rowLength;
+		image.rowCount = layout.rowCount;
+		image.pixels = static_cast<const uint8_t*>(slots[slot].mappedData);
+		callback(image);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		slots[slot].state = SlotState::Free;
+	}
+}
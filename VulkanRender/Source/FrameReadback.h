@@ -0,0 +1,123 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "GpuTimeline.h"
+#include "Utilities.h"
+
+// Buffers in readback ring, frame is collected this many frames after it was copied (at the latest)
+const int READBACK_RING_SIZE = MAX_FRAME_DRAWS + 1;
+
+// How a frame is laid out in a readback buffer
+struct ReadbackLayout
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t rowLength = 0;				// Pixels per row in buffer (>= width if rows are padded)
+	uint32_t rowCount = 0;				// Rows in buffer (of first plane for planar formats)
+	VkDeviceSize size = 0;				// Bytes per frame
+};
+
+// Pixels of one read back frame, only valid during callback
+struct ReadbackImage
+{
+	uint64_t frameNumber = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t rowLength = 0;
+	uint32_t rowCount = 0;
+	const uint8_t* pixels = nullptr;
+};
+
+typedef std::function<void(const ReadbackImage&)> ReadbackCallback;
+
+// Asynchronous GPU to CPU frame readback
+// Copy is recorded at end of frame's command buffer in to a ring of host cached buffers,
+// finished copies are picked up frames later (never waiting for GPU) and handed to a worker thread
+// If all buffers are busy the frame is simply not captured
+class FrameReadback
+{
+public:
+	FrameReadback();
+
+	// Ring for plain copies of 4 byte per pixel images
+	void Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkExtent2D newExtent, VkFormat newFormat, const ReadbackCallback& newCallback);
+
+	// Ring for any layout, buffers get extra usage if something other than a copy writes them (e.g. compute)
+	void Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, const ReadbackLayout& newLayout, VkBufferUsageFlags extraUsage, const ReadbackCallback& newCallback);
+
+	bool IsActive();
+	int GetSlotCount();
+	VkBuffer GetSlotBuffer(int slot);
+
+	// Reserve next buffer of ring for a frame, -1 if it is still busy (frame should be dropped)
+	int AcquireSlot();
+
+	// Record copy of image (in given layout, left in that layout) in to a free buffer, -1 if none free
+	// Whatever wrote image last has to make it visible to transfer stage (e.g. render pass dependency to VK_SUBPASS_EXTERNAL)
+	int RecordCopy(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout);
+
+	// Copy of slot was submitted, it is finished when timeline reaches value
+	void Submitted(int slot, uint64_t timelineValue, uint64_t frameNumber);
+
+	// Hand finished copies to worker thread (non-blocking)
+	void Collect(GpuTimeline* timeline);
+
+	// Finish work of worker thread and free buffers (GPU must be done with them)
+	void Destroy();
+
+	// Write image as binary PPM (P6), alpha is dropped
+	static void WritePPM(const std::string& fileName, const ReadbackImage& image);
+
+	~FrameReadback();
+
+private:
+	enum class SlotState
+	{
+		Free,			// Can be copied to
+		Recorded,		// Copy recorded, not submitted yet
+		InFlight,		// Copy submitted, GPU not finished
+		Processing		// Worker thread reading pixels
+	};
+
+	struct Slot
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mappedData = nullptr;
+		SlotState state = SlotState::Free;
+		uint64_t timelineValue = 0;
+		uint64_t frameNumber = 0;
+	};
+
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	ReadbackLayout layout;
+	bool hostCoherent = false;				// Cached memory may not be coherent, then it has to be invalidated before reading
+
+	std::vector<Slot> slots;
+	int nextSlot = 0;
+	std::deque<int> inFlightSlots;			// Submitted copies, oldest first
+
+	// - Worker
+	ReadbackCallback callback;
+	std::thread worker;
+	std::mutex mutex;						// Guards slot states and work queue
+	std::condition_variable workReady;
+	std::deque<int> workQueue;
+	bool stopWorker = false;
+
+	void WorkerLoop();
+};
@@ -0,0 +1,207 @@
+#include "GpuStatistics.h"
+
+// Counters asked for, results come back in bit order (same order as PassStatistics)
+static const VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+static const uint32_t STATISTIC_COUNT = 7;
+
+static const char* passName(GpuPass pass)
+{
+	switch (pass)
+	{
+	case GPU_PASS_MAIN: return "main";
+	default: return "unknown";
+	}
+}
+
+GpuStatistics::GpuStatistics()
+{
+}
+
+void GpuStatistics::Init(VkDevice newDevice, bool supported)
+{
+	device = newDevice;
+	if (!supported)
+	{
+		printf("Pipeline statistics queries not supported, GPU statistics disabled\n");
+		return;
+	}
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	queryPoolCreateInfo.queryCount = GPU_STATISTICS_RING_SIZE * GPU_PASS_COUNT;
+	queryPoolCreateInfo.pipelineStatistics = STATISTIC_FLAGS;
+
+	VkResult result = vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &queryPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Statistics Query Pool!");
+	}
+
+	slots.resize(GPU_STATISTICS_RING_SIZE);
+}
+
+bool GpuStatistics::IsActive()
+{
+	return queryPool != VK_NULL_HANDLE;
+}
+
+int GpuStatistics::BeginFrame(VkCommandBuffer commandBuffer)
+{
+	if (!IsActive() || slots[nextSlot].state != SlotState::Free)
+	{
+		return -1;
+	}
+
+	int slot = nextSlot;
+	nextSlot = (nextSlot + 1) % static_cast<int>(slots.size());
+
+	slots[slot] = Slot();
+	slots[slot].state = SlotState::Recorded;
+
+	// Queries have to be reset before they are begun again
+	vkCmdResetQueryPool(commandBuffer, queryPool, QueryIndex(slot, (GpuPass)0), GPU_PASS_COUNT);
+
+	return slot;
+}
+
+void GpuStatistics::BeginPass(VkCommandBuffer commandBuffer, int slot, GpuPass pass)
+{
+	if (slot < 0)
+	{
+		return;
+	}
+
+	vkCmdBeginQuery(commandBuffer, queryPool, QueryIndex(slot, pass), 0);
+	slots[slot].passRecorded[pass] = true;
+}
+
+void GpuStatistics::EndPass(VkCommandBuffer commandBuffer, int slot, GpuPass pass)
+{
+	if (slot < 0)
+	{
+		return;
+	}
+
+	vkCmdEndQuery(commandBuffer, queryPool, QueryIndex(slot, pass));
+}
+
+void GpuStatistics::Submitted(int slot, uint64_t timelineValue, uint64_t frameNumber)
+{
+	if (slot < 0)
+	{
+		return;
+	}
+
+	slots[slot].state = SlotState::InFlight;
+	slots[slot].timelineValue = timelineValue;
+	slots[slot].frameNumber = frameNumber;
+	inFlightSlots.push_back(slot);
+}
+
+void GpuStatistics::Collect(GpuTimeline* timeline)
+{
+	// Frames finish in submission order, stop at first one GPU is still working on
+	while (!inFlightSlots.empty() && timeline->IsReached(slots[inFlightSlots.front()].timelineValue))
+	{
+		int slot = inFlightSlots.front();
+		inFlightSlots.pop_front();
+
+		GpuFrameStatistics frame;
+		frame.frameNumber = slots[slot].frameNumber;
+		frame.valid = true;
+
+		for (int pass = 0; pass < GPU_PASS_COUNT; pass++)
+		{
+			// Queries of passes that did not run were never begun, they would never become available
+			if (!slots[slot].passRecorded[pass])
+			{
+				continue;
+			}
+
+			// Frame is finished, so results are there; no wait flag, a driver still holding them just loses this frame
+			uint64_t results[STATISTIC_COUNT + 1] = {};
+			VkResult result = vkGetQueryPoolResults(device, queryPool, QueryIndex(slot, (GpuPass)pass), 1, sizeof(results), results, sizeof(results),
+				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			if (result != VK_SUCCESS || results[STATISTIC_COUNT] == 0)
+			{
+				continue;
+			}
+
+			PassStatistics& statistics = frame.passes[pass];
+			statistics.recorded = true;
+			statistics.inputAssemblyVertices = results[0];
+			statistics.inputAssemblyPrimitives = results[1];
+			statistics.vertexShaderInvocations = results[2];
+			statistics.clippingInvocations = results[3];
+			statistics.clippingPrimitives = results[4];
+			statistics.fragmentShaderInvocations = results[5];
+			statistics.computeShaderInvocations = results[6];
+		}
+
+		slots[slot].state = SlotState::Free;
+		lastFrame = frame;
+
+		if (dump)
+		{
+			Print(frame);
+		}
+	}
+}
+
+GpuFrameStatistics GpuStatistics::GetLastFrame()
+{
+	return lastFrame;
+}
+
+void GpuStatistics::SetDump(bool enable)
+{
+	dump = enable;
+}
+
+void GpuStatistics::Destroy()
+{
+	if (queryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+	slots.clear();
+	inFlightSlots.clear();
+	nextSlot = 0;
+}
+
+void GpuStatistics::Print(const GpuFrameStatistics& statistics)
+{
+	for (int pass = 0; pass < GPU_PASS_COUNT; pass++)
+	{
+		const PassStatistics& passStatistics = statistics.passes[pass];
+		if (!passStatistics.recorded)
+		{
+			continue;
+		}
+
+		printf("Frame %llu %s pass: IA vertices %llu, IA primitives %llu, VS %llu, clip in %llu, clip out %llu, FS %llu, CS %llu\n",
+			(unsigned long long)statistics.frameNumber, passName((GpuPass)pass),
+			(unsigned long long)passStatistics.inputAssemblyVertices, (unsigned long long)passStatistics.inputAssemblyPrimitives,
+			(unsigned long long)passStatistics.vertexShaderInvocations, (unsigned long long)passStatistics.clippingInvocations,
+			(unsigned long long)passStatistics.clippingPrimitives, (unsigned long long)passStatistics.fragmentShaderInvocations,
+			(unsigned long long)passStatistics.computeShaderInvocations);
+	}
+}
+
+GpuStatistics::~GpuStatistics()
+{
+}
+
+uint32_t GpuStatistics::QueryIndex(int slot, GpuPass pass)
+{
+	return static_cast<uint32_t>(slot * GPU_PASS_COUNT + pass);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+
+#include "GpuTimeline.h"
+#include "Utilities.h"
+
+// Query slots in ring, results of a frame are read this many frames after it was recorded (at the latest)
+const int GPU_STATISTICS_RING_SIZE = MAX_FRAME_DRAWS + 1;
+
+// Passes of a frame pipeline statistics are gathered for (one query each)
+// Transfer-only work (readback and video copies) has no counters, and video YUV conversion runs in it's own
+// compute queue submission, outside of frame's command buffer, so neither is measured
+enum GpuPass
+{
+	GPU_PASS_MAIN,				// Main render pass
+	GPU_PASS_COUNT
+};
+
+// Counters of one pass (VK_QUERY_TYPE_PIPELINE_STATISTICS)
+struct PassStatistics
+{
+	bool recorded = false;						// Pass ran in this frame
+	uint64_t inputAssemblyVertices = 0;
+	uint64_t inputAssemblyPrimitives = 0;
+	uint64_t vertexShaderInvocations = 0;
+	uint64_t clippingInvocations = 0;			// Primitives reaching clipping stage
+	uint64_t clippingPrimitives = 0;			// Primitives left after clipping (culled/clipped ones are missing)
+	uint64_t fragmentShaderInvocations = 0;
+	uint64_t computeShaderInvocations = 0;
+};
+
+struct GpuFrameStatistics
+{
+	uint64_t frameNumber = 0;
+	bool valid = false;							// False until first frame was collected
+	PassStatistics passes[GPU_PASS_COUNT];
+};
+
+// Pipeline statistics queries around each pass of a frame
+// Queries live in a ring of per frame slots, results are only read once frame's timeline value is reached,
+// so collecting never stalls CPU or GPU; if all slots are busy the frame is simply not measured
+class GpuStatistics
+{
+public:
+	GpuStatistics();
+
+	// Does nothing if device has no pipelineStatisticsQuery feature (supported = false)
+	void Init(VkDevice newDevice, bool supported);
+
+	bool IsActive();
+
+	// Reserve a slot for a frame and reset it's queries (outside render pass), -1 if ring is full
+	int BeginFrame(VkCommandBuffer commandBuffer);
+
+	void BeginPass(VkCommandBuffer commandBuffer, int slot, GpuPass pass);
+	void EndPass(VkCommandBuffer commandBuffer, int slot, GpuPass pass);
+
+	// Frame of slot was submitted, results are ready when timeline reaches value
+	void Submitted(int slot, uint64_t timelineValue, uint64_t frameNumber);
+
+	// Read results of finished frames (non-blocking), prints each one if dump is on
+	void Collect(GpuTimeline* timeline);
+
+	// Latest collected frame
+	GpuFrameStatistics GetLastFrame();
+
+	// Print statistics of every collected frame
+	void SetDump(bool enable);
+
+	void Destroy();
+
+	static void Print(const GpuFrameStatistics& statistics);
+
+	~GpuStatistics();
+
+private:
+	enum class SlotState
+	{
+		Free,
+		Recorded,
+		InFlight
+	};
+
+	struct Slot
+	{
+		SlotState state = SlotState::Free;
+		bool passRecorded[GPU_PASS_COUNT] = {};
+		uint64_t timelineValue = 0;
+		uint64_t frameNumber = 0;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+
+	std::vector<Slot> slots;
+	int nextSlot = 0;
+	std::deque<int> inFlightSlots;			// Submitted frames, oldest first
+
+	GpuFrameStatistics lastFrame;
+	bool dump = false;
+
+	uint32_t QueryIndex(int slot, GpuPass pass);
+};
@@ -0,0 +1,102 @@
+#include "GpuTimeline.h"
+
+#include <limits>
+
+GpuTimeline::GpuTimeline()
+{
+}
+
+void GpuTimeline::Init(VkDevice newDevice)
+{
+	device = newDevice;
+	lastSignalValue = 0;
+	completedValue = 0;
+
+	// Timeline type of semaphore, starting at 0 (nothing submitted yet)
+	VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {};
+	semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphoreTypeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+	VkResult result = vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Timeline Semaphore!");
+	}
+}
+
+VkSemaphore GpuTimeline::GetSemaphore()
+{
+	return semaphore;
+}
+
+uint64_t GpuTimeline::NextValue()
+{
+	return ++lastSignalValue;
+}
+
+uint64_t GpuTimeline::GetLastSignalValue()
+{
+	return lastSignalValue;
+}
+
+uint64_t GpuTimeline::GetCompletedValue()
+{
+	// Nothing outstanding, no need to ask the driver
+	if (completedValue == lastSignalValue)
+	{
+		return completedValue;
+	}
+
+	VkResult result = vkGetSemaphoreCounterValue(device, semaphore, &completedValue);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to get Timeline Semaphore value!");
+	}
+
+	return completedValue;
+}
+
+bool GpuTimeline::IsReached(uint64_t value)
+{
+	return value <= completedValue || value <= GetCompletedValue();
+}
+
+void GpuTimeline::Wait(uint64_t value)
+{
+	if (IsReached(value))
+	{
+		return;
+	}
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+
+	VkResult result = vkWaitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to wait on Timeline Semaphore!");
+	}
+
+	completedValue = value > completedValue ? value : completedValue;
+}
+
+void GpuTimeline::Destroy()
+{
+	if (semaphore != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(device, semaphore, nullptr);
+		semaphore = VK_NULL_HANDLE;
+	}
+}
+
+GpuTimeline::~GpuTimeline()
+{
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+
+// One monotonically increasing GPU timeline (Vulkan 1.2 timeline semaphore)
+// Every submission signals the next value, so "has GPU finished X" is just a value comparison
+class GpuTimeline
+{
+public:
+	GpuTimeline();
+
+	void Init(VkDevice newDevice);
+
+	VkSemaphore GetSemaphore();
+
+	// Value the next submission should signal (call once per submission, in submission order)
+	uint64_t NextValue();
+
+	// Highest value handed out to a submission so far
+	uint64_t GetLastSignalValue();
+
+	// Highest value GPU has reached (polls semaphore)
+	uint64_t GetCompletedValue();
+
+	bool IsReached(uint64_t value);
+	void Wait(uint64_t value);
+
+	void Destroy();
+
+	~GpuTimeline();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+
+	uint64_t lastSignalValue = 0;
+	uint64_t completedValue = 0;		// Cached last known completed value (GPU only moves forward)
+};
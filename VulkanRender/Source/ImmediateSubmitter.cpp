@@ -0,0 +1,291 @@
+#include "ImmediateSubmitter.h"
+
+ImmediateSubmitter::ImmediateSubmitter()
+{
+}
+
+void ImmediateSubmitter::Init(VkDevice newDevice, VkQueue newQueue, uint32_t newQueueFamilyIndex, GpuTimeline* newTimeline)
+{
+	device = newDevice;
+	queue = newQueue;
+	queueFamilyIndex = newQueueFamilyIndex;
+	timeline = newTimeline;
+
+	openBatch = Batch();
+	openBatch.token = nextToken;
+}
+
+SubmitToken ImmediateSubmitter::Record(const std::function<void(VkCommandBuffer)>& job, const std::function<void()>& onComplete)
+{
+	// Start a command buffer for batch with first job
+	if (openBatch.jobCount == 0)
+	{
+		openBatch.context = AcquireContext();
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;		// Buffer is submitted once, then pool is reset
+
+		VkResult result = vkBeginCommandBuffer(openBatch.context.commandBuffer, &beginInfo);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to start recording an Immediate Command Buffer!");
+		}
+	}
+
+	job(openBatch.context.commandBuffer);
+	openBatch.jobCount++;
+
+	if (onComplete)
+	{
+		openBatch.completions.push_back(onComplete);
+	}
+
+	return openBatch.token;
+}
+
+void ImmediateSubmitter::WaitFor(ImmediateSubmitter* producer, SubmitToken token, VkPipelineStageFlags waitStage)
+{
+	Dependency dependency;
+	dependency.producer = producer;
+	dependency.token = token;
+	dependency.waitStage = waitStage;
+	openBatch.dependencies.push_back(dependency);
+}
+
+void ImmediateSubmitter::WaitFor(GpuTimeline* producerTimeline, uint64_t value, VkPipelineStageFlags waitStage)
+{
+	Dependency dependency;
+	dependency.timeline = producerTimeline;
+	dependency.value = value;
+	dependency.waitStage = waitStage;
+	openBatch.dependencies.push_back(dependency);
+}
+
+SubmitToken ImmediateSubmitter::Flush()
+{
+	// Nothing recorded, so everything given out so far is already submitted
+	if (openBatch.jobCount == 0)
+	{
+		return openBatch.token - 1;
+	}
+
+	VkResult result = vkEndCommandBuffer(openBatch.context.commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to end recording an Immediate Command Buffer!");
+	}
+
+	// Batch signals next value of timeline when finished
+	openBatch.timelineValue = timeline->NextValue();
+	VkSemaphore timelineSemaphore = timeline->GetSemaphore();
+
+	// Wait on timelines of other queues this batch depends on
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<uint64_t> waitValues;
+	std::vector<VkPipelineStageFlags> waitStages;
+	for (Dependency& dependency : openBatch.dependencies)
+	{
+		if (dependency.producer == nullptr)
+		{
+			waitSemaphores.push_back(dependency.timeline->GetSemaphore());
+			waitValues.push_back(dependency.value);
+			waitStages.push_back(dependency.waitStage);
+			continue;
+		}
+
+		// Signal has to be submitted before (or with) the wait
+		if (dependency.token >= dependency.producer->openBatch.token)
+		{
+			dependency.producer->Flush();
+		}
+
+		waitSemaphores.push_back(dependency.producer->timeline->GetSemaphore());
+		waitValues.push_back(dependency.producer->GetTimelineValue(dependency.token));
+		waitStages.push_back(dependency.waitStage);
+	}
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &openBatch.timelineValue;
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineSubmitInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &openBatch.context.commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+	result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to submit Immediate Command Buffer to Queue!");
+	}
+
+	SubmitToken token = openBatch.token;
+	submittedBatches.push_back(openBatch);
+
+	// Open next batch
+	nextToken++;
+	openBatch = Batch();
+	openBatch.token = nextToken;
+
+	return token;
+}
+
+bool ImmediateSubmitter::IsComplete(SubmitToken token)
+{
+	if (token <= completedToken)
+	{
+		return true;
+	}
+
+	Collect();
+	return token <= completedToken;
+}
+
+void ImmediateSubmitter::Wait(SubmitToken token)
+{
+	if (token <= completedToken)
+	{
+		return;
+	}
+
+	// Work still in open batch has to be submitted first
+	if (token >= openBatch.token)
+	{
+		Flush();
+	}
+
+	timeline->Wait(GetTimelineValue(token));
+
+	Collect();
+}
+
+uint64_t ImmediateSubmitter::GetTimelineValue(SubmitToken token)
+{
+	for (Batch& batch : submittedBatches)
+	{
+		if (batch.token == token)
+		{
+			return batch.timelineValue;
+		}
+	}
+
+	// Already retired batches have been reached anyway
+	return token <= completedToken ? timeline->GetCompletedValue() : 0;
+}
+
+void ImmediateSubmitter::Collect()
+{
+	// Batches signal increasing timeline values, so they finish in order; stop at first unfinished one
+	while (!submittedBatches.empty())
+	{
+		Batch& batch = submittedBatches.front();
+		if (!timeline->IsReached(batch.timelineValue))
+		{
+			break;
+		}
+
+		Retire(batch);
+		submittedBatches.pop_front();
+	}
+}
+
+uint32_t ImmediateSubmitter::GetQueueFamilyIndex()
+{
+	return queueFamilyIndex;
+}
+
+GpuTimeline* ImmediateSubmitter::GetTimeline()
+{
+	return timeline;
+}
+
+void ImmediateSubmitter::Destroy()
+{
+	if (device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	// Make sure everything recorded reached the GPU and finished
+	Flush();
+	if (!submittedBatches.empty())
+	{
+		timeline->Wait(submittedBatches.back().timelineValue);
+	}
+	Collect();
+
+	for (CommandContext& context : freeContexts)
+	{
+		vkDestroyCommandPool(device, context.commandPool, nullptr);
+	}
+	freeContexts.clear();
+
+	device = VK_NULL_HANDLE;
+}
+
+ImmediateSubmitter::~ImmediateSubmitter()
+{
+}
+
+ImmediateSubmitter::CommandContext ImmediateSubmitter::AcquireContext()
+{
+	// Reuse a recycled pool if there is one
+	if (!freeContexts.empty())
+	{
+		CommandContext context = freeContexts.back();
+		freeContexts.pop_back();
+		return context;
+	}
+
+	CommandContext context;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;			// Buffers are short lived, lets driver optimise allocations
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+	VkResult result = vkCreateCommandPool(device, &poolInfo, nullptr, &context.commandPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Transient Command Pool!");
+	}
+
+	VkCommandBufferAllocateInfo cbAllocateInfo = {};
+	cbAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	cbAllocateInfo.commandPool = context.commandPool;
+	cbAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	cbAllocateInfo.commandBufferCount = 1;
+
+	result = vkAllocateCommandBuffers(device, &cbAllocateInfo, &context.commandBuffer);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate an Immediate Command Buffer!");
+	}
+
+	return context;
+}
+
+void ImmediateSubmitter::Retire(Batch& batch)
+{
+	for (std::function<void()>& completion : batch.completions)
+	{
+		completion();
+	}
+
+	// Resetting whole pool is cheaper than resetting single buffers
+	vkResetCommandPool(device, batch.context.commandPool, 0);
+
+	freeContexts.push_back(batch.context);
+
+	completedToken = batch.token;
+}
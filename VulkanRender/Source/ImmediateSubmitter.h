@@ -0,0 +1,103 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include "GpuTimeline.h"
+
+// Completion token of submitted work (increase with each batch, 0 = nothing to wait for)
+typedef uint64_t SubmitToken;
+
+// Pooled "immediate submit" service for one-shot work outside the frame loop (uploads, layout transitions...)
+// Jobs recorded between flushes are batched into one command buffer and one queue submission,
+// callers get a token they can poll or wait on instead of vkQueueWaitIdle
+// Completion is tracked on a GPU timeline shared with the rest of the queue's work, so no fences are needed
+class ImmediateSubmitter
+{
+public:
+	ImmediateSubmitter();
+
+	void Init(VkDevice newDevice, VkQueue newQueue, uint32_t newQueueFamilyIndex, GpuTimeline* newTimeline);
+
+	// Record a job in to current batch, onComplete will be called once GPU finished the batch
+	SubmitToken Record(const std::function<void(VkCommandBuffer)>& job, const std::function<void()>& onComplete = nullptr);
+
+	// Make current batch wait (on GPU) for work of another submitter, e.g. queue family ownership acquire after a release
+	// Producer's batch is flushed first if needed, so the semaphore handoff is always submitted in order
+	void WaitFor(ImmediateSubmitter* producer, SubmitToken token, VkPipelineStageFlags waitStage);
+
+	// Make current batch wait (on GPU) for a value of a timeline signalled outside any submitter, e.g. a frame's submission
+	// Signalling submission has to be made before this batch is flushed
+	void WaitFor(GpuTimeline* producerTimeline, uint64_t value, VkPipelineStageFlags waitStage);
+
+	// Submit current batch (if anything was recorded), does not wait
+	SubmitToken Flush();
+
+	// Non-blocking check if work of given token has finished
+	bool IsComplete(SubmitToken token);
+
+	// Block until work of given token has finished (only that batch is waited on)
+	void Wait(SubmitToken token);
+
+	// Timeline value signalled when work of given token finishes (0 if not submitted yet)
+	uint64_t GetTimelineValue(SubmitToken token);
+
+	// Retire finished batches: call completion callbacks, recycle command pools
+	void Collect();
+
+	uint32_t GetQueueFamilyIndex();
+	GpuTimeline* GetTimeline();
+
+	void Destroy();
+
+	~ImmediateSubmitter();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint32_t queueFamilyIndex = 0;
+	GpuTimeline* timeline = nullptr;
+
+	// Transient command pool with its single command buffer, reset as a whole when recycled
+	struct CommandContext
+	{
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	};
+
+	// Work of another submitter (queue) the batch has to wait for, or a plain timeline value if there is no producer
+	struct Dependency
+	{
+		ImmediateSubmitter* producer = nullptr;
+		SubmitToken token = 0;
+		GpuTimeline* timeline = nullptr;
+		uint64_t value = 0;
+		VkPipelineStageFlags waitStage = 0;
+	};
+
+	struct Batch
+	{
+		SubmitToken token = 0;
+		CommandContext context;
+		uint64_t timelineValue = 0;				// Value signalled on timeline when batch finishes
+		uint32_t jobCount = 0;
+		std::vector<std::function<void()>> completions;
+		std::vector<Dependency> dependencies;
+	};
+
+	Batch openBatch;						// Batch currently recording (jobCount == 0 if nothing recorded)
+	std::deque<Batch> submittedBatches;		// Batches in flight, oldest first
+
+	std::vector<CommandContext> freeContexts;
+
+	SubmitToken nextToken = 1;
+	SubmitToken completedToken = 0;
+
+	CommandContext AcquireContext();
+	void Retire(Batch& batch);
+};
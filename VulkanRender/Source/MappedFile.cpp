@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+{
+}
+
+bool MappedFile::Open(const std::string& fileName)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int file = open(fileName.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	fileHandle = reinterpret_cast<void*>(static_cast<intptr_t>(file) + 1);		// + 1 so descriptor 0 is not null
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	size = static_cast<size_t>(fileStat.st_size);
+
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	data = mapped == MAP_FAILED ? nullptr : mapped;
+#endif
+
+	if (data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+const void* MappedFile::GetData()
+{
+	return data;
+}
+
+size_t MappedFile::GetSize()
+{
+	return size;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr)
+	{
+		CloseHandle(fileHandle);
+	}
+#else
+	if (data != nullptr)
+	{
+		munmap(const_cast<void*>(data), size);
+	}
+	if (fileHandle != nullptr)
+	{
+		close(static_cast<int>(reinterpret_cast<intptr_t>(fileHandle) - 1));
+	}
+#endif
+
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	data = nullptr;
+	size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+// Mapping starts on a page boundary, so data is always aligned well enough to be read as uint32_t (SPIR-V words)
+// Pages are loaded by OS on first touch, nothing is copied in to a buffer of our own
+class MappedFile
+{
+public:
+	MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// False if file does not exist, is empty or can't be mapped
+	bool Open(const std::string& fileName);
+
+	const void* GetData();
+	size_t GetSize();
+
+	void Close();
+
+	~MappedFile();
+
+private:
+	void* fileHandle = nullptr;			// HANDLE on Windows, file descriptor elsewhere
+	void* mappingHandle = nullptr;		// File mapping object (Windows only)
+	const void* data = nullptr;
+	size_t size = 0;
+};
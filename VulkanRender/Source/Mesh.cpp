@@ -4,12 +4,12 @@ Mesh::Mesh()
 {
 }
 
-Mesh::Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, std::vector<Vertex>* vertices)
+Mesh::Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ImmediateSubmitter* uploader, ImmediateSubmitter* owner, std::vector<Vertex>* vertices)
 {
 	vertexCount = vertices->size();
 	physicalDevice = newPhysicalDevice;
 	device = newDevice;
-	CreateVertexBuffer(vertices);
+	CreateVertexBuffer(uploader, owner, vertices);
 }
 
 int Mesh::GetVertexCount()
@@ -22,77 +22,140 @@ VkBuffer Mesh::GetVertexBuffer()
 	return vertexBuffer;
 }
 
-void Mesh::DestroyVertexBuffer()
+SubmitToken Mesh::GetUploadToken()
 {
-	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
+	return uploadToken;
 }
 
-Mesh::~Mesh()
-{
-}
-
-VkBuffer Mesh::CreateVertexBuffer(std::vector<Vertex>* vertices)
+void Mesh::DestroyVertexBuffer(DeletionQueue* deletionQueue)
 {
-	// CREATE VERTEX BUFFER
-	// Information to create a buffer (doesn't include assigning memory)
-	VkBufferCreateInfo bufferInfo = {};
-	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferInfo.size = sizeof(Vertex) * vertices->size();			// Size of buffer (size of 1 vertex * number of vertices)
-	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;			// Multiple types of buffer posible, we want Vertex Buffer
-	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;				// Similar to Swap Chain images, can share vertex buffer
-
-	VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, &vertexBuffer);
-	if (result != VK_SUCCESS)
+	if (vertexBuffer == VK_NULL_HANDLE)
 	{
-		throw std::runtime_error("Failed to create a Vertex Buffer!");
+		return;
 	}
 
-	// Get buffer memory requirements
-	VkMemoryRequirements memRequirements = {};
-	vkGetBufferMemoryRequirements(device, vertexBuffer, &memRequirements);
-
-	// Allocate memory to buffer
-	VkMemoryAllocateInfo memAllocInfo = {};
-	memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memAllocInfo.allocationSize = memRequirements.size;
-	memAllocInfo.memoryTypeIndex = FindMemoryTypeIndex(memRequirements.memoryTypeBits,			// Index of memory type on Physical Device that has required bit flags
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);			// VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT : CPU can iteract with memory
-																								// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : Allows placement of data straight into buffer after mapping (otherwise would have to specify manually)
-
-	// Allocate memory to VKDeviceMemory
-	result = vkAllocateMemory(device, &memAllocInfo, nullptr, &vertexBufferMemory);
-	if (result != VK_SUCCESS)
+	if (deletionQueue != nullptr)
+	{
+		// Frames already submitted may still read the buffer
+		VkDevice bufferDevice = device;
+		VkBuffer buffer = vertexBuffer;
+		VkDeviceMemory bufferMemory = vertexBufferMemory;
+		deletionQueue->Push(
+			[=]()
+			{
+				vkDestroyBuffer(bufferDevice, buffer, nullptr);
+				vkFreeMemory(bufferDevice, bufferMemory, nullptr);
+			});
+	}
+	else
 	{
-		throw std::runtime_error("Failed to allocate Vertex Buffer Memory!");
+		vkDestroyBuffer(device, vertexBuffer, nullptr);
+		vkFreeMemory(device, vertexBufferMemory, nullptr);
 	}
 
-	// Allocate memory to given vertex buffer
-	vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory, 0);
+	// Mesh no longer has a buffer to draw
+	vertexBuffer = VK_NULL_HANDLE;
+	vertexBufferMemory = VK_NULL_HANDLE;
+}
 
-	// MAP MEMORY TO VERTEX BUFFER
-	void* data;																	// 1. Create pointer to a point in normal memory
-	vkMapMemory(device, vertexBufferMemory, 0, bufferInfo.size, 0, &data);		// 2. "Map" the vertex buffer memory to that point 
-	memcpy(data, vertices->data(), (size_t)bufferInfo.size);					// 3. Copy memory from vertices vector to the point
-	vkUnmapMemory(device, vertexBufferMemory);									// 4. Unmap the vertex buffer memory
+Mesh::~Mesh()
+{
 }
 
-uint32_t Mesh::FindMemoryTypeIndex(uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+VkBuffer Mesh::CreateVertexBuffer(ImmediateSubmitter* uploader, ImmediateSubmitter* owner, std::vector<Vertex>* vertices)
 {
-	// Get properties of physical device memory
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	// Get size of buffer needed for vertices
+	VkDeviceSize bufferSize = sizeof(Vertex) * vertices->size();
 
-	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
-	{
-		// Index of memory type must match corresponding bit in allowedTypes
-		// and desired property bit flag are part of memory type's property flags
-		if ((allowedTypes & (1 << i))
-			&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+	// Temporary buffer to "stage" vertex data before transferring to GPU
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+
+	// Create Staging Buffer and Allocate Memory to it
+	createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,		// VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT : CPU can iteract with memory
+		&stagingBuffer, &stagingBufferMemory);											// VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : Allows placement of data straight into buffer after mapping (otherwise would have to specify manually)
+
+	// MAP MEMORY TO STAGING BUFFER
+	void* data;																	// 1. Create pointer to a point in normal memory
+	vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);			// 2. "Map" the staging buffer memory to that point 
+	memcpy(data, vertices->data(), (size_t)bufferSize);							// 3. Copy memory from vertices vector to the point
+	vkUnmapMemory(device, stagingBufferMemory);									// 4. Unmap the staging buffer memory
+
+	// Create buffer with TRANSFER_DST_BIT to mark as recipient of transfer data (also VERTEX_BUFFER)
+	// Buffer memory is to be DEVICE_LOCAL_BIT meaning memory is on the GPU and only accessible by it and not CPU (host)
+	createBuffer(physicalDevice, device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vertexBuffer, &vertexBufferMemory);
+
+	// Buffer is exclusive, so if copy runs on another queue family, ownership has to be released there and acquired by owner
+	uint32_t srcQueueFamily = uploader->GetQueueFamilyIndex();
+	uint32_t dstQueueFamily = owner->GetQueueFamilyIndex();
+	bool ownershipTransfer = srcQueueFamily != dstQueueFamily;
+
+	// Copy staging buffer to vertex buffer on GPU, batched with other uploads
+	VkBuffer dstBuffer = vertexBuffer;
+	VkDevice uploadDevice = device;
+	uploadToken = uploader->Record(
+		[=](VkCommandBuffer commandBuffer)
+		{
+			// Region of data to copy from and to
+			VkBufferCopy bufferCopyRegion = {};
+			bufferCopyRegion.srcOffset = 0;
+			bufferCopyRegion.dstOffset = 0;
+			bufferCopyRegion.size = bufferSize;
+			vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer, 1, &bufferCopyRegion);
+
+			VkBufferMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.buffer = dstBuffer;
+			barrier.offset = 0;
+			barrier.size = bufferSize;
+
+			if (ownershipTransfer)
+			{
+				// Release half of ownership transfer (destination access/stage are ignored on releasing queue)
+				barrier.dstAccessMask = 0;
+				barrier.srcQueueFamilyIndex = srcQueueFamily;
+				barrier.dstQueueFamilyIndex = dstQueueFamily;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			}
+			else
+			{
+				// Make copied data visible to vertex input of any later submission on this queue
+				barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			}
+		},
+		[=]()
 		{
-			// This memory type is valid, so return it's index
-			return i;
-		}
+			// Staging buffer no longer needed once GPU finished the copy
+			vkDestroyBuffer(uploadDevice, stagingBuffer, nullptr);
+			vkFreeMemory(uploadDevice, stagingBufferMemory, nullptr);
+		});
+
+	if (ownershipTransfer)
+	{
+		// Owner's batch waits for the copy (timeline semaphore), then acquires buffer with matching barrier
+		// Barrier starts at the stage the semaphore wait blocks, so the acquire is ordered after the release
+		owner->WaitFor(uploader, uploadToken, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		owner->Record(
+			[=](VkCommandBuffer commandBuffer)
+			{
+				VkBufferMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+				barrier.srcQueueFamilyIndex = srcQueueFamily;
+				barrier.dstQueueFamilyIndex = dstQueueFamily;
+				barrier.buffer = dstBuffer;
+				barrier.offset = 0;
+				barrier.size = bufferSize;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			});
 	}
-	return 0;
+
+	return vertexBuffer;
 }
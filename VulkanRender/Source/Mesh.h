@@ -6,28 +6,33 @@
 #include <vector>
 
 #include "Utilities.h"
+#include "ImmediateSubmitter.h"
+#include "DeletionQueue.h"
 
 class Mesh
 {
 public:
 	Mesh();
-	Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, std::vector<Vertex>* vertices);
+	// uploader copies vertices (ideally on a transfer queue), owner acquires buffer on the queue rendering with it
+	Mesh(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, ImmediateSubmitter* uploader, ImmediateSubmitter* owner, std::vector<Vertex>* vertices);
 
 	int GetVertexCount();
 	VkBuffer GetVertexBuffer();
+	SubmitToken GetUploadToken();
 
-	void DestroyVertexBuffer();
+	// Destroy now (GPU must be idle), or once GPU is done with it if a deletion queue is given
+	void DestroyVertexBuffer(DeletionQueue* deletionQueue = nullptr);
 
 	~Mesh();
 
 private:
 	int vertexCount;
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+	SubmitToken uploadToken = 0;		// Token of the upload copying vertices to the GPU
 
 	VkPhysicalDevice physicalDevice;
 	VkDevice device;
 
-	VkBuffer CreateVertexBuffer(std::vector<Vertex>* vertices);
-	uint32_t FindMemoryTypeIndex(uint32_t allowedTypes, VkMemoryPropertyFlags properties);
+	VkBuffer CreateVertexBuffer(ImmediateSubmitter* uploader, ImmediateSubmitter* owner, std::vector<Vertex>* vertices);
 };
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "PipelineCache.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+PipelineCache::PipelineCache()
+{
+}
+
+void PipelineCache::Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, const std::string& newFileName)
+{
+	device = newDevice;
+	fileName = newFileName;
+	loaded = false;
+
+	vkGetPhysicalDeviceProperties(newPhysicalDevice, &deviceProperties);
+
+	// Read previous blob, a missing file just means a cold start
+	std::vector<char> data;
+	std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+	if (file.is_open())
+	{
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+		file.close();
+
+		if (!IsCompatible(data))
+		{
+			printf("Pipeline cache %s was written by another device or driver, ignored\n", fileName.c_str());
+			data.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheCreateInfo = {};
+	cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheCreateInfo.initialDataSize = data.size();
+	cacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	VkResult result = vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &cache);
+	if (result != VK_SUCCESS && !data.empty())
+	{
+		// Driver refused blob anyway, start empty
+		cacheCreateInfo.initialDataSize = 0;
+		cacheCreateInfo.pInitialData = nullptr;
+		data.clear();
+		result = vkCreatePipelineCache(device, &cacheCreateInfo, nullptr, &cache);
+	}
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Pipeline Cache!");
+	}
+
+	loaded = !data.empty();
+	printf("Pipeline cache: %s (%s, %zu bytes)\n", fileName.c_str(), loaded ? "warm" : "cold", data.size());
+}
+
+VkPipelineCache PipelineCache::GetCache()
+{
+	return cache;
+}
+
+bool PipelineCache::WasLoaded()
+{
+	return loaded;
+}
+
+void PipelineCache::Save()
+{
+	if (cache == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	// Get size first, then data
+	size_t dataSize = 0;
+	VkResult result = vkGetPipelineCacheData(device, cache, &dataSize, nullptr);
+	if (result != VK_SUCCESS || dataSize == 0)
+	{
+		return;
+	}
+	std::vector<char> data(dataSize);
+	result = vkGetPipelineCacheData(device, cache, &dataSize, data.data());
+	if (result != VK_SUCCESS)
+	{
+		printf("Failed to get Pipeline Cache data, not saved\n");
+		return;
+	}
+
+	std::string tempFileName = fileName + ".tmp";
+	std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		printf("Failed to open %s, pipeline cache not saved\n", tempFileName.c_str());
+		return;
+	}
+	file.write(data.data(), dataSize);
+	file.close();
+	if (file.fail())
+	{
+		printf("Failed to write %s, pipeline cache not saved\n", tempFileName.c_str());
+		std::remove(tempFileName.c_str());
+		return;
+	}
+
+	// Replace old file in one step (rename on Windows fails if target exists)
+#ifdef _WIN32
+	bool moved = MoveFileExA(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool moved = std::rename(tempFileName.c_str(), fileName.c_str()) == 0;
+#endif
+	if (!moved)
+	{
+		printf("Failed to replace %s, pipeline cache not saved\n", fileName.c_str());
+		std::remove(tempFileName.c_str());
+		return;
+	}
+
+	printf("Pipeline cache saved: %s (%zu bytes)\n", fileName.c_str(), dataSize);
+}
+
+void PipelineCache::Destroy()
+{
+	if (cache != VK_NULL_HANDLE)
+	{
+		vkDestroyPipelineCache(device, cache, nullptr);
+		cache = VK_NULL_HANDLE;
+	}
+}
+
+PipelineCache::~PipelineCache()
+{
+}
+
+bool PipelineCache::IsCompatible(const std::vector<char>& data)
+{
+	// Every cache blob starts with this header (Vulkan spec), checked here since some drivers trust it blindly
+	VkPipelineCacheHeaderVersionOne header = {};
+	if (data.size() < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+
+	return header.headerSize >= sizeof(header)
+		&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& header.vendorID == deviceProperties.vendorID
+		&& header.deviceID == deviceProperties.deviceID
+		&& memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
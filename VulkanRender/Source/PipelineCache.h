@@ -0,0 +1,40 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+// VkPipelineCache persisted between runs, so pipelines are compiled by the driver only on first launch
+// Blob is only reused if it was written by the same vendor, device and driver (pipelineCacheUUID), otherwise starts empty
+class PipelineCache
+{
+public:
+	PipelineCache();
+
+	void Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, const std::string& newFileName);
+
+	VkPipelineCache GetCache();
+
+	// True if a valid blob was loaded from disk (pipelines should be "warm")
+	bool WasLoaded();
+
+	// Write cache contents to temporary file and move it over old one, so a crash never leaves a half written cache
+	void Save();
+
+	void Destroy();
+
+	~PipelineCache();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties deviceProperties = {};
+
+	std::string fileName;
+	bool loaded = false;
+
+	bool IsCompatible(const std::vector<char>& data);
+};
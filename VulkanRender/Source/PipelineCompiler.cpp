@@ -0,0 +1,123 @@
+#include "PipelineCompiler.h"
+
+#include <algorithm>
+
+PipelineCompiler::PipelineCompiler()
+{
+}
+
+void PipelineCompiler::Init(VkPipelineCache newPipelineCache, uint32_t threadCount)
+{
+	pipelineCache = newPipelineCache;
+	stopping = false;
+
+	if (threadCount == 0)
+	{
+		uint32_t cores = std::thread::hardware_concurrency();
+		threadCount = cores > 2 ? std::min(cores - 2, 4u) : 1;
+	}
+
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		threads.push_back(std::thread(&PipelineCompiler::WorkerLoop, this));
+	}
+
+	printf("Pipeline compiler: %u threads\n", threadCount);
+}
+
+PipelineFuture PipelineCompiler::Submit(const PipelineBuildJob& job)
+{
+	BuildRequest request;
+	request.job = job;
+	PipelineFuture future = request.promise.get_future().share();
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		requests.push_back(std::move(request));
+	}
+	queueCondition.notify_one();
+
+	return future;
+}
+
+bool PipelineCompiler::IsReady(const PipelineFuture& future)
+{
+	return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+VkPipeline PipelineCompiler::GetIfReady(const PipelineFuture& future)
+{
+	if (!IsReady(future))
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	try
+	{
+		return future.get();
+	}
+	catch (const std::exception&)
+	{
+		return VK_NULL_HANDLE;
+	}
+}
+
+uint32_t PipelineCompiler::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return static_cast<uint32_t>(requests.size()) + activeCount;
+}
+
+void PipelineCompiler::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+}
+
+void PipelineCompiler::WorkerLoop()
+{
+	while (true)
+	{
+		BuildRequest request;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return stopping || !requests.empty(); });
+
+			// Queue is drained before stopping, so no future is left without a value
+			if (requests.empty())
+			{
+				return;
+			}
+
+			request = std::move(requests.front());
+			requests.pop_front();
+			activeCount++;
+		}
+
+		try
+		{
+			request.promise.set_value(request.job(pipelineCache));
+		}
+		catch (const std::exception& e)
+		{
+			printf("ERROR: Pipeline build failed: %s\n", e.what());
+			request.promise.set_exception(std::current_exception());
+		}
+
+		std::lock_guard<std::mutex> lock(queueMutex);
+		activeCount--;
+	}
+}
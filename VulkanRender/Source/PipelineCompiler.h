@@ -0,0 +1,66 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <chrono>
+
+// Pipeline being compiled in background, get() returns it (or rethrows the compile error) once ready
+typedef std::shared_future<VkPipeline> PipelineFuture;
+
+// Job building one pipeline against given pipeline cache, runs on a compiler thread
+typedef std::function<VkPipeline(VkPipelineCache)> PipelineBuildJob;
+
+// Background pipeline compilation on a small thread pool
+// Driver compiles pipelines on the calling thread, so doing it here keeps Init and frames free of compile stalls
+// All threads share one VkPipelineCache (it is internally synchronised), so later runs are warm
+class PipelineCompiler
+{
+public:
+	PipelineCompiler();
+
+	// threadCount 0 = leave one core for main and one for simulation thread
+	void Init(VkPipelineCache newPipelineCache, uint32_t threadCount = 0);
+
+	// Queue a pipeline build, never blocks
+	PipelineFuture Submit(const PipelineBuildJob& job);
+
+	// Non-blocking check if pipeline of future can be used (false for empty future)
+	static bool IsReady(const PipelineFuture& future);
+
+	// Pipeline of future if it is ready and compiled fine, otherwise VK_NULL_HANDLE (never blocks or throws)
+	static VkPipeline GetIfReady(const PipelineFuture& future);
+
+	uint32_t GetPendingCount();
+
+	// Finish queued builds, then stop threads (pipelines are owned by whoever submitted them)
+	void Destroy();
+
+	~PipelineCompiler();
+
+private:
+	struct BuildRequest
+	{
+		PipelineBuildJob job;
+		std::promise<VkPipeline> promise;
+	};
+
+	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+	std::vector<std::thread> threads;
+
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	std::deque<BuildRequest> requests;		// Guarded by queueMutex
+	uint32_t activeCount = 0;				// Builds running right now, guarded by queueMutex
+	bool stopping = false;					// Guarded by queueMutex
+
+	void WorkerLoop();
+};
@@ -0,0 +1,334 @@
+#include "PipelineDescription.h"
+
+#include <cstring>
+
+// 64 bit FNV-1a, fed field by field so struct padding never ends up in the hash
+static void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+template<typename T>
+static void hashValue(uint64_t& hash, const T& value)
+{
+	hashBytes(hash, &value, sizeof(T));
+}
+
+static void hashString(uint64_t& hash, const std::string& value)
+{
+	hashValue(hash, value.size());
+	hashBytes(hash, value.data(), value.size());
+}
+
+// First topology of each class, any topology of a class can be set dynamically on a pipeline made with another one
+static VkPrimitiveTopology topologyClass(VkPrimitiveTopology topology)
+{
+	switch (topology)
+	{
+	case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+	case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+		return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+	case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+		return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+	default:
+		return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	}
+}
+
+ShaderConstant ShaderConstant::Int(VkShaderStageFlagBits stage, uint32_t constantId, int32_t value)
+{
+	ShaderConstant constant;
+	constant.stage = stage;
+	constant.constantId = constantId;
+	memcpy(&constant.value, &value, sizeof(value));
+	return constant;
+}
+
+ShaderConstant ShaderConstant::Float(VkShaderStageFlagBits stage, uint32_t constantId, float value)
+{
+	ShaderConstant constant;
+	constant.stage = stage;
+	constant.constantId = constantId;
+	memcpy(&constant.value, &value, sizeof(value));
+	return constant;
+}
+
+ShaderConstant ShaderConstant::Bool(VkShaderStageFlagBits stage, uint32_t constantId, bool value)
+{
+	ShaderConstant constant;
+	constant.stage = stage;
+	constant.constantId = constantId;
+	constant.value = value ? VK_TRUE : VK_FALSE;
+	return constant;
+}
+
+const VkSpecializationInfo* ShaderSpecialization::Get()
+{
+	if (entries.empty())
+	{
+		return nullptr;
+	}
+
+	info.mapEntryCount = static_cast<uint32_t>(entries.size());
+	info.pMapEntries = entries.data();
+	info.dataSize = data.size() * sizeof(uint32_t);
+	info.pData = data.data();
+	return &info;
+}
+
+void PipelineDescription::SetSpecializationConstant(const ShaderConstant& constant)
+{
+	for (ShaderConstant& existing : specializationConstants)
+	{
+		if (existing.stage == constant.stage && existing.constantId == constant.constantId)
+		{
+			existing.value = constant.value;
+			return;
+		}
+	}
+
+	// Kept sorted, so same constants set in different order still give equal descriptions
+	auto position = specializationConstants.begin();
+	while (position != specializationConstants.end()
+		&& (position->stage < constant.stage || (position->stage == constant.stage && position->constantId < constant.constantId)))
+	{
+		++position;
+	}
+	specializationConstants.insert(position, constant);
+}
+
+void PipelineDescription::GetSpecialization(VkShaderStageFlagBits stage, ShaderSpecialization& specialization) const
+{
+	specialization.entries.clear();
+	specialization.data.clear();
+
+	for (const ShaderConstant& constant : specializationConstants)
+	{
+		if (constant.stage != stage)
+		{
+			continue;
+		}
+
+		VkSpecializationMapEntry entry = {};
+		entry.constantID = constant.constantId;
+		entry.offset = static_cast<uint32_t>(specialization.data.size() * sizeof(uint32_t));
+		entry.size = sizeof(uint32_t);
+		specialization.entries.push_back(entry);
+		specialization.data.push_back(constant.value);
+	}
+}
+
+PipelineDescription PipelineDescription::GetPipelineKey() const
+{
+	PipelineDescription key = *this;
+	PipelineDescription defaults;
+
+	if (dynamicStates & PIPELINE_DYNAMIC_CULL_MODE)
+	{
+		key.cullMode = defaults.cullMode;
+	}
+	if (dynamicStates & PIPELINE_DYNAMIC_FRONT_FACE)
+	{
+		key.frontFace = defaults.frontFace;
+	}
+	if (dynamicStates & PIPELINE_DYNAMIC_TOPOLOGY)
+	{
+		key.topology = topologyClass(topology);
+	}
+	if (dynamicStates & PIPELINE_DYNAMIC_PRIMITIVE_RESTART)
+	{
+		key.primitiveRestartEnable = defaults.primitiveRestartEnable;
+	}
+	if (dynamicStates & PIPELINE_DYNAMIC_POLYGON_MODE)
+	{
+		key.polygonMode = defaults.polygonMode;
+	}
+	if (dynamicStates & PIPELINE_DYNAMIC_BLEND)
+	{
+		key.blendEnable = defaults.blendEnable;
+		key.srcColorBlendFactor = defaults.srcColorBlendFactor;
+		key.dstColorBlendFactor = defaults.dstColorBlendFactor;
+		key.colorBlendOp = defaults.colorBlendOp;
+		key.srcAlphaBlendFactor = defaults.srcAlphaBlendFactor;
+		key.dstAlphaBlendFactor = defaults.dstAlphaBlendFactor;
+		key.alphaBlendOp = defaults.alphaBlendOp;
+		key.colorWriteMask = defaults.colorWriteMask;
+	}
+
+	return key;
+}
+
+// Constants of one stage only, so e.g. a fragment constant does not split vertex parts
+static void copyStageConstants(const std::vector<ShaderConstant>& constants, VkShaderStageFlagBits stage, std::vector<ShaderConstant>& stageConstants)
+{
+	for (const ShaderConstant& constant : constants)
+	{
+		if (constant.stage == stage)
+		{
+			stageConstants.push_back(constant);
+		}
+	}
+}
+
+PipelineDescription PipelineDescription::GetLibraryPart(VkGraphicsPipelineLibraryFlagBitsEXT part) const
+{
+	PipelineDescription description;
+
+	switch (part)
+	{
+	case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+		description.vertexStride = vertexStride;
+		description.vertexInputRate = vertexInputRate;
+		description.vertexAttributes = vertexAttributes;
+		description.topology = topology;
+		description.primitiveRestartEnable = primitiveRestartEnable;
+		description.dynamicStates = dynamicStates & (PIPELINE_DYNAMIC_TOPOLOGY | PIPELINE_DYNAMIC_PRIMITIVE_RESTART);
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+		description.vertexShaderFile = vertexShaderFile;
+		description.polygonMode = polygonMode;
+		description.cullMode = cullMode;
+		description.frontFace = frontFace;
+		description.colorFormat = colorFormat;
+		description.dynamicStates = dynamicStates & (PIPELINE_DYNAMIC_CULL_MODE | PIPELINE_DYNAMIC_FRONT_FACE | PIPELINE_DYNAMIC_POLYGON_MODE);
+		copyStageConstants(specializationConstants, VK_SHADER_STAGE_VERTEX_BIT, description.specializationConstants);
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+		description.fragmentShaderFile = fragmentShaderFile;
+		description.colorFormat = colorFormat;
+		description.sampleCount = sampleCount;
+		copyStageConstants(specializationConstants, VK_SHADER_STAGE_FRAGMENT_BIT, description.specializationConstants);
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+		description.blendEnable = blendEnable;
+		description.srcColorBlendFactor = srcColorBlendFactor;
+		description.dstColorBlendFactor = dstColorBlendFactor;
+		description.colorBlendOp = colorBlendOp;
+		description.srcAlphaBlendFactor = srcAlphaBlendFactor;
+		description.dstAlphaBlendFactor = dstAlphaBlendFactor;
+		description.alphaBlendOp = alphaBlendOp;
+		description.colorWriteMask = colorWriteMask;
+		description.colorFormat = colorFormat;
+		description.sampleCount = sampleCount;
+		description.dynamicStates = dynamicStates & PIPELINE_DYNAMIC_BLEND;
+		break;
+	default:
+		break;
+	}
+
+	return description;
+}
+
+uint64_t PipelineDescription::Hash() const
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	hashString(hash, vertexShaderFile);
+	hashString(hash, fragmentShaderFile);
+
+	hashValue(hash, vertexStride);
+	hashValue(hash, vertexInputRate);
+	hashValue(hash, vertexAttributes.size());
+	for (const VkVertexInputAttributeDescription& attribute : vertexAttributes)
+	{
+		hashValue(hash, attribute.location);
+		hashValue(hash, attribute.binding);
+		hashValue(hash, attribute.format);
+		hashValue(hash, attribute.offset);
+	}
+	hashValue(hash, topology);
+	hashValue(hash, primitiveRestartEnable);
+
+	hashValue(hash, polygonMode);
+	hashValue(hash, cullMode);
+	hashValue(hash, frontFace);
+
+	hashValue(hash, blendEnable);
+	hashValue(hash, srcColorBlendFactor);
+	hashValue(hash, dstColorBlendFactor);
+	hashValue(hash, colorBlendOp);
+	hashValue(hash, srcAlphaBlendFactor);
+	hashValue(hash, dstAlphaBlendFactor);
+	hashValue(hash, alphaBlendOp);
+	hashValue(hash, colorWriteMask);
+
+	hashValue(hash, colorFormat);
+	hashValue(hash, sampleCount);
+	hashValue(hash, dynamicStates);
+
+	hashValue(hash, specializationConstants.size());
+	for (const ShaderConstant& constant : specializationConstants)
+	{
+		hashValue(hash, constant.stage);
+		hashValue(hash, constant.constantId);
+		hashValue(hash, constant.value);
+	}
+
+	return hash;
+}
+
+bool PipelineDescription::operator==(const PipelineDescription& other) const
+{
+	if (vertexAttributes.size() != other.vertexAttributes.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < vertexAttributes.size(); i++)
+	{
+		const VkVertexInputAttributeDescription& a = vertexAttributes[i];
+		const VkVertexInputAttributeDescription& b = other.vertexAttributes[i];
+		if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+		{
+			return false;
+		}
+	}
+
+	if (specializationConstants.size() != other.specializationConstants.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < specializationConstants.size(); i++)
+	{
+		const ShaderConstant& a = specializationConstants[i];
+		const ShaderConstant& b = other.specializationConstants[i];
+		if (a.stage != b.stage || a.constantId != b.constantId || a.value != b.value)
+		{
+			return false;
+		}
+	}
+
+	return vertexShaderFile == other.vertexShaderFile
+		&& fragmentShaderFile == other.fragmentShaderFile
+		&& vertexStride == other.vertexStride
+		&& vertexInputRate == other.vertexInputRate
+		&& topology == other.topology
+		&& primitiveRestartEnable == other.primitiveRestartEnable
+		&& polygonMode == other.polygonMode
+		&& cullMode == other.cullMode
+		&& frontFace == other.frontFace
+		&& blendEnable == other.blendEnable
+		&& srcColorBlendFactor == other.srcColorBlendFactor
+		&& dstColorBlendFactor == other.dstColorBlendFactor
+		&& colorBlendOp == other.colorBlendOp
+		&& srcAlphaBlendFactor == other.srcAlphaBlendFactor
+		&& dstAlphaBlendFactor == other.dstAlphaBlendFactor
+		&& alphaBlendOp == other.alphaBlendOp
+		&& colorWriteMask == other.colorWriteMask
+		&& colorFormat == other.colorFormat
+		&& sampleCount == other.sampleCount
+		&& dynamicStates == other.dynamicStates;
+}
+
+bool PipelineDescription::operator!=(const PipelineDescription& other) const
+{
+	return !(*this == other);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+#include <string>
+
+// Pipeline state set while recording instead of being baked in to pipeline (PipelineDescription::dynamicStates)
+// Only used for states the device supports as dynamic (VK_EXT_extended_dynamic_state, 2 and 3)
+enum PipelineDynamicStateBits : uint32_t
+{
+	PIPELINE_DYNAMIC_CULL_MODE = 1 << 0,
+	PIPELINE_DYNAMIC_FRONT_FACE = 1 << 1,
+	PIPELINE_DYNAMIC_TOPOLOGY = 1 << 2,				// Within same topology class (points, lines, triangles, patches)
+	PIPELINE_DYNAMIC_PRIMITIVE_RESTART = 1 << 3,
+	PIPELINE_DYNAMIC_POLYGON_MODE = 1 << 4,
+	PIPELINE_DYNAMIC_BLEND = 1 << 5,				// Blend enable, blend equation and colour write mask
+};
+
+// One specialization constant (layout(constant_id = X) in shader), baked in when pipeline is built
+// Value is stored as raw 32 bits: int, uint, float and bool (VkBool32) constants all fit
+struct ShaderConstant
+{
+	VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+	uint32_t constantId = 0;
+	uint32_t value = 0;
+
+	static ShaderConstant Int(VkShaderStageFlagBits stage, uint32_t constantId, int32_t value);
+	static ShaderConstant Float(VkShaderStageFlagBits stage, uint32_t constantId, float value);
+	static ShaderConstant Bool(VkShaderStageFlagBits stage, uint32_t constantId, bool value);
+};
+
+// VkSpecializationInfo of one shader stage together with the arrays it points in to
+// Not copyable on purpose, info would still point in to the original
+struct ShaderSpecialization
+{
+	std::vector<VkSpecializationMapEntry> entries;
+	std::vector<uint32_t> data;
+	VkSpecializationInfo info = {};
+
+	ShaderSpecialization() = default;
+	ShaderSpecialization(const ShaderSpecialization&) = delete;
+	ShaderSpecialization& operator=(const ShaderSpecialization&) = delete;
+
+	// Info for VkPipelineShaderStageCreateInfo::pSpecializationInfo, nullptr if stage has no constants
+	const VkSpecializationInfo* Get();
+};
+
+// Everything that makes one graphics pipeline different from another
+// Viewport and scissor are not here, they are dynamic state set while recording
+// Defaults match the demo pipeline, so a description only needs shaders, vertex layout and target format
+struct PipelineDescription
+{
+	// - Shaders (SPIR-V files)
+	std::string vertexShaderFile;
+	std::string fragmentShaderFile;
+
+	// - Vertex layout (single binding)
+	uint32_t vertexStride = 0;
+	VkVertexInputRate vertexInputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes;		// Empty = from vertex shader inputs, packed in location order
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkBool32 primitiveRestartEnable = VK_FALSE;
+
+	// - Rasterizer
+	VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+	// - Blending (single colour attachment)
+	VkBool32 blendEnable = VK_TRUE;
+	VkBlendFactor srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	VkBlendFactor dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	VkBlendOp colorBlendOp = VK_BLEND_OP_ADD;
+	VkBlendFactor srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp alphaBlendOp = VK_BLEND_OP_ADD;
+	VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	// - Render pass compatibility (attachment format and samples, not the handle)
+	VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
+
+	// - State set while recording (PipelineDynamicStateBits), values above are still the ones to draw with
+	uint32_t dynamicStates = 0;
+
+	// - Specialization constants, each set of values is it's own pipeline (driver folds constants and drops dead branches)
+	std::vector<ShaderConstant> specializationConstants;
+
+	// Add constant, or replace value if stage already has one with that id
+	void SetSpecializationConstant(const ShaderConstant& constant);
+
+	// Fill specialization of one shader stage from constants above
+	void GetSpecialization(VkShaderStageFlagBits stage, ShaderSpecialization& specialization) const;
+
+	// Copy with dynamic state values reset, so descriptions differing only in dynamic state share one pipeline
+	PipelineDescription GetPipelineKey() const;
+
+	// Copy with only state of one graphics pipeline library part (VK_GRAPHICS_PIPELINE_LIBRARY_*_BIT_EXT), rest left default
+	// Descriptions sharing e.g. vertex shader and raster state give equal pre-rasterization parts
+	PipelineDescription GetLibraryPart(VkGraphicsPipelineLibraryFlagBitsEXT part) const;
+
+	// Stable over runs (no pointers or handles hashed), equal descriptions always give equal hashes
+	// Shaders are hashed by file name, not content (hashing content would mean reading shaders on the calling thread)
+	uint64_t Hash() const;
+
+	bool operator==(const PipelineDescription& other) const;
+	bool operator!=(const PipelineDescription& other) const;
+};
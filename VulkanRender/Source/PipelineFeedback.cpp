@@ -0,0 +1,72 @@
+#include "PipelineFeedback.h"
+
+PipelineFeedback::PipelineFeedback()
+{
+}
+
+void PipelineFeedback::Init(bool newSupported)
+{
+	supported = newSupported;
+}
+
+void PipelineFeedback::Attach(VkGraphicsPipelineCreateInfo& createInfo, PipelineFeedbackRecord& record)
+{
+	if (!supported)
+	{
+		return;
+	}
+
+	// One feedback per shader stage of create info (library links have none of their own)
+	record.stages.assign(createInfo.stageCount, VkPipelineCreationFeedbackEXT());
+
+	record.info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+	record.info.pNext = createInfo.pNext;
+	record.info.pPipelineCreationFeedback = &record.pipeline;
+	record.info.pipelineStageCreationFeedbackCount = static_cast<uint32_t>(record.stages.size());
+	record.info.pPipelineStageCreationFeedbacks = record.stages.empty() ? nullptr : record.stages.data();
+
+	createInfo.pNext = &record.info;
+}
+
+void PipelineFeedback::Report(const PipelineFeedbackRecord& record, const char* label)
+{
+	// Driver may leave feedback empty, then there is nothing to trust
+	if (!supported || !(record.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT))
+	{
+		return;
+	}
+
+	bool cacheHit = (record.pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) != 0;
+	double creationMs = record.pipeline.duration / 1000000.0;
+
+	uint32_t stageHits = 0;
+	for (const VkPipelineCreationFeedbackEXT& stage : record.stages)
+	{
+		if ((stage.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) && (stage.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT))
+		{
+			stageHits++;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		stats.pipelineCount++;
+		stats.cacheHits += cacheHit ? 1 : 0;
+		stats.stageCount += static_cast<uint32_t>(record.stages.size());
+		stats.stageCacheHits += stageHits;
+		stats.creationMs += creationMs;
+	}
+
+	printf("Pipeline feedback (%s): %.2f ms, cache %s, stages hit %u/%u\n", label, creationMs, cacheHit ? "hit" : "miss",
+		stageHits, static_cast<uint32_t>(record.stages.size()));
+}
+
+PipelineCreationStats PipelineFeedback::GetStats()
+{
+	std::lock_guard<std::mutex> lock(statsMutex);
+	return stats;
+}
+
+PipelineFeedback::~PipelineFeedback()
+{
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+#include <mutex>
+
+// Totals over all pipeline creations reported so far
+struct PipelineCreationStats
+{
+	uint32_t pipelineCount = 0;			// Creations with valid feedback
+	uint32_t cacheHits = 0;				// Whole pipeline came from pipeline cache
+	uint32_t stageCount = 0;
+	uint32_t stageCacheHits = 0;
+	double creationMs = 0.0;			// Driver side creation time
+};
+
+// Feedback structs of one vkCreate*Pipelines call, have to stay alive until the call returns
+// Not copyable on purpose, create info points in to it
+struct PipelineFeedbackRecord
+{
+	VkPipelineCreationFeedbackEXT pipeline = {};
+	std::vector<VkPipelineCreationFeedbackEXT> stages;
+	VkPipelineCreationFeedbackCreateInfoEXT info = {};
+
+	PipelineFeedbackRecord() = default;
+	PipelineFeedbackRecord(const PipelineFeedbackRecord&) = delete;
+	PipelineFeedbackRecord& operator=(const PipelineFeedbackRecord&) = delete;
+};
+
+// VK_EXT_pipeline_creation_feedback on every graphics pipeline creation: was it a cache hit, how long did driver take
+// Safe to use from several compiler threads at once
+class PipelineFeedback
+{
+public:
+	PipelineFeedback();
+
+	// Nothing is chained if device has no VK_EXT_pipeline_creation_feedback (supported = false)
+	void Init(bool newSupported);
+
+	// Chain feedback in front of create info's pNext chain (call right before vkCreateGraphicsPipelines)
+	void Attach(VkGraphicsPipelineCreateInfo& createInfo, PipelineFeedbackRecord& record);
+
+	// Log and count feedback of a finished creation
+	void Report(const PipelineFeedbackRecord& record, const char* label);
+
+	PipelineCreationStats GetStats();
+
+	~PipelineFeedback();
+
+private:
+	bool supported = false;
+
+	std::mutex statsMutex;
+	PipelineCreationStats stats;		// Guarded by statsMutex
+};
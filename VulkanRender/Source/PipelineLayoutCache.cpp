@@ -0,0 +1,230 @@
+#include "PipelineLayoutCache.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <string>
+
+PipelineLayoutCache::PipelineLayoutCache()
+{
+}
+
+void PipelineLayoutCache::Init(VkDevice newDevice, ShaderModuleCache* newShaderModules, uint32_t newMaxPushConstantsSize)
+{
+	device = newDevice;
+	shaderModules = newShaderModules;
+	maxPushConstantsSize = newMaxPushConstantsSize;
+}
+
+void PipelineLayoutCache::SetDynamicUniformSet(uint32_t set)
+{
+	dynamicUniformSet = set;
+}
+
+PipelineLayoutInfo PipelineLayoutCache::Get(const PipelineDescription& description)
+{
+	std::vector<const ShaderReflection*> stages;
+	stages.push_back(&shaderModules->GetReflection(shaderModules->Get(description.vertexShaderFile)));
+	stages.push_back(&shaderModules->GetReflection(shaderModules->Get(description.fragmentShaderFile)));
+	return Get(stages);
+}
+
+PipelineLayoutInfo PipelineLayoutCache::Get(const std::vector<const ShaderReflection*>& stages)
+{
+	// Merge bindings of all stages, a binding used by several stages is visible to all of them
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+	VkPushConstantRange pushConstantRange = {};
+	for (const ShaderReflection* stage : stages)
+	{
+		for (const ShaderBinding& shaderBinding : stage->bindings)
+		{
+			VkDescriptorType descriptorType = shaderBinding.descriptorType;
+			if (shaderBinding.set == dynamicUniformSet && descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			{
+				descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			}
+
+			if (sets.size() <= shaderBinding.set)
+			{
+				sets.resize(shaderBinding.set + 1);
+			}
+
+			std::vector<VkDescriptorSetLayoutBinding>& set = sets[shaderBinding.set];
+			auto existing = std::find_if(set.begin(), set.end(), [&](const VkDescriptorSetLayoutBinding& binding)
+			{
+				return binding.binding == shaderBinding.binding;
+			});
+			if (existing == set.end())
+			{
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding = shaderBinding.binding;
+				binding.descriptorType = descriptorType;
+				binding.descriptorCount = shaderBinding.descriptorCount;
+				binding.stageFlags = stage->stage;
+				set.push_back(binding);
+			}
+			else if (existing->descriptorType != descriptorType || existing->descriptorCount != shaderBinding.descriptorCount)
+			{
+				throw std::runtime_error("Failed to create Pipeline Layout, shader stages disagree on a descriptor binding!");
+			}
+			else
+			{
+				existing->stageFlags |= stage->stage;
+			}
+		}
+
+		// One range for all stages using push constants, so a single vkCmdPushConstants updates them
+		if (stage->pushConstantSize > 0)
+		{
+			pushConstantRange.stageFlags |= stage->stage;
+			pushConstantRange.size = std::max(pushConstantRange.size, stage->pushConstantSize);
+		}
+	}
+
+	// Range size has to be a multiple of 4 and fit in what device can push
+	pushConstantRange.size = (pushConstantRange.size + 3) & ~3u;
+	if (pushConstantRange.size > maxPushConstantsSize)
+	{
+		throw std::runtime_error("Failed to create Pipeline Layout, push constants (" + std::to_string(pushConstantRange.size) +
+			" bytes) exceed maxPushConstantsSize (" + std::to_string(maxPushConstantsSize) + " bytes)!");
+	}
+
+	for (std::vector<VkDescriptorSetLayoutBinding>& set : sets)
+	{
+		std::sort(set.begin(), set.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+		{
+			return a.binding < b.binding;
+		});
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Pipeline layout key: key of every set layout, then push constant range
+	std::vector<VkDescriptorSetLayout> setLayoutHandles;
+	std::vector<uint32_t> key;
+	for (std::vector<VkDescriptorSetLayoutBinding>& set : sets)
+	{
+		std::vector<uint32_t> setKey;
+		setLayoutHandles.push_back(GetSetLayout(set, setKey));
+		key.push_back(static_cast<uint32_t>(setKey.size()));
+		key.insert(key.end(), setKey.begin(), setKey.end());
+	}
+	key.push_back(pushConstantRange.stageFlags);
+	key.push_back(pushConstantRange.size);
+
+	auto found = pipelineLayouts.find(key);
+	if (found != pipelineLayouts.end())
+	{
+		stats.hits++;
+		return found->second;
+	}
+
+	PipelineLayoutInfo info;
+	info.setLayouts = setLayoutHandles;
+	info.pushConstantRange = pushConstantRange;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(info.setLayouts.size());
+	pipelineLayoutCreateInfo.pSetLayouts = info.setLayouts.data();
+	pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &info.pushConstantRange;
+
+	VkResult result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &info.layout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create Pipeline Layout!");
+	}
+
+	pipelineLayouts[key] = info;
+	stats.pipelineLayoutCount++;
+	printf("Pipeline Layout created: %zu descriptor sets, %u bytes of push constants\n", info.setLayouts.size(), pushConstantRange.size);
+
+	return info;
+}
+
+void PipelineLayoutCache::ValidateVertexInput(const PipelineDescription& description)
+{
+	const ShaderReflection& vertexShader = shaderModules->GetReflection(shaderModules->Get(description.vertexShaderFile));
+	for (const ShaderInput& input : vertexShader.inputs)
+	{
+		auto attribute = std::find_if(description.vertexAttributes.begin(), description.vertexAttributes.end(),
+			[&](const VkVertexInputAttributeDescription& candidate)
+		{
+			return candidate.location == input.location;
+		});
+
+		std::string location = std::to_string(input.location);
+		if (attribute == description.vertexAttributes.end())
+		{
+			throw std::runtime_error("Vertex shader " + description.vertexShaderFile + " reads location " + location + " that has no vertex attribute!");
+		}
+		if (attribute->format != input.format)
+		{
+			throw std::runtime_error("Vertex shader " + description.vertexShaderFile + " reads location " + location + " in another format than its vertex attribute!");
+		}
+		if (attribute->offset + input.size > description.vertexStride)
+		{
+			throw std::runtime_error("Vertex shader " + description.vertexShaderFile + " reads location " + location + " past vertex stride!");
+		}
+	}
+}
+
+PipelineLayoutCacheStats PipelineLayoutCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void PipelineLayoutCache::Destroy()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& pipelineLayout : pipelineLayouts)
+	{
+		vkDestroyPipelineLayout(device, pipelineLayout.second.layout, nullptr);
+	}
+	for (auto& setLayout : setLayouts)
+	{
+		vkDestroyDescriptorSetLayout(device, setLayout.second, nullptr);
+	}
+	pipelineLayouts.clear();
+	setLayouts.clear();
+	stats = PipelineLayoutCacheStats();
+}
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, std::vector<uint32_t>& key)
+{
+	key.clear();
+	for (const VkDescriptorSetLayoutBinding& binding : bindings)
+	{
+		key.push_back(binding.binding);
+		key.push_back(static_cast<uint32_t>(binding.descriptorType));
+		key.push_back(binding.descriptorCount);
+		key.push_back(binding.stageFlags);
+	}
+
+	auto found = setLayouts.find(key);
+	if (found != setLayouts.end())
+	{
+		return found->second;
+	}
+
+	VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+	setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	setLayoutCreateInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout setLayout;
+	VkResult result = vkCreateDescriptorSetLayout(device, &setLayoutCreateInfo, nullptr, &setLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Descriptor Set Layout!");
+	}
+
+	setLayouts[key] = setLayout;
+	stats.setLayoutCount++;
+	return setLayout;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include "PipelineDescription.h"
+#include "ShaderModuleCache.h"
+#include "ShaderReflection.h"
+
+struct PipelineLayoutCacheStats
+{
+	uint32_t setLayoutCount = 0;
+	uint32_t pipelineLayoutCount = 0;
+	uint32_t hits = 0;					// Lookups answered by an existing pipeline layout
+};
+
+// Pipeline layout with what it was made of
+struct PipelineLayoutInfo
+{
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSetLayout> setLayouts;		// Indexed by set number (unused sets get an empty layout)
+	VkPushConstantRange pushConstantRange = {};			// size 0 = no push constants
+};
+
+// Descriptor set layouts and pipeline layouts derived from SPIR-V reflection of a pipeline's shaders
+// Equal layouts are created once and shared, so pipelines with compatible shaders get the very same layout
+// and descriptor sets bound for one stay bound when switching to another
+// Safe to call from several pipeline compiler threads at once; layouts live until Destroy
+class PipelineLayoutCache
+{
+public:
+	PipelineLayoutCache();
+
+	// Layouts whose push constants don't fit maxPushConstantsSize of device are refused
+	void Init(VkDevice newDevice, ShaderModuleCache* newShaderModules, uint32_t newMaxPushConstantsSize);
+
+	// Uniform buffers in set become UNIFORM_BUFFER_DYNAMIC (reflection can't tell), call before first Get
+	void SetDynamicUniformSet(uint32_t set);
+
+	// Layout matching shaders of description (loads shader modules if needed)
+	// Throws if stages disagree on a binding or push constants exceed device limit
+	PipelineLayoutInfo Get(const PipelineDescription& description);
+
+	// Layout matching given shader stages
+	PipelineLayoutInfo Get(const std::vector<const ShaderReflection*>& stages);
+
+	// Check vertex attributes of description against vertex shader inputs (attributes themselves come from Vertex layout)
+	// Throws if shader reads a location with no attribute, in another format, or past vertexStride
+	void ValidateVertexInput(const PipelineDescription& description);
+
+	PipelineLayoutCacheStats GetStats();
+
+	void Destroy();
+
+	~PipelineLayoutCache();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	ShaderModuleCache* shaderModules = nullptr;
+	uint32_t dynamicUniformSet = UINT32_MAX;		// None
+	uint32_t maxPushConstantsSize = 128;			// Minimum every device guarantees
+
+	// Keys are the create info contents flattened to words
+	std::mutex mutex;														// Guards everything below
+	std::map<std::vector<uint32_t>, VkDescriptorSetLayout> setLayouts;
+	std::map<std::vector<uint32_t>, PipelineLayoutInfo> pipelineLayouts;
+	PipelineLayoutCacheStats stats;
+
+	VkDescriptorSetLayout GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, std::vector<uint32_t>& key);
+};
@@ -0,0 +1,328 @@
+#include "PipelineLibrary.h"
+
+PipelineLibrary::PipelineLibrary()
+{
+}
+
+void PipelineLibrary::Init(VkDevice newDevice, VkRenderPass newRenderPass, PipelineFeedback* newFeedback, ShaderModuleCache* newShaderModules)
+{
+	device = newDevice;
+	renderPass = newRenderPass;
+	feedback = newFeedback;
+	shaderModules = newShaderModules;
+}
+
+VkPipeline PipelineLibrary::Link(VkPipelineCache cache, const PipelineDescription& description, VkPipelineLayout pipelineLayout, bool optimized)
+{
+	// Parts without shaders do not use a layout, so they are shared by all layouts
+	VkPipeline libraries[] = {
+		GetPart(cache, description, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, VK_NULL_HANDLE),
+		GetPart(cache, description, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, pipelineLayout),
+		GetPart(cache, description, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, pipelineLayout),
+		GetPart(cache, description, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, VK_NULL_HANDLE),
+	};
+
+	VkPipelineLibraryCreateInfoKHR libraryCreateInfo = {};
+	libraryCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+	libraryCreateInfo.libraryCount = 4;
+	libraryCreateInfo.pLibraries = libraries;
+
+	// Without link time optimization linking is just gluing compiled parts together
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.pNext = &libraryCreateInfo;
+	pipelineCreateInfo.flags = optimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+	pipelineCreateInfo.layout = pipelineLayout;
+	pipelineCreateInfo.basePipelineIndex = -1;
+
+	PipelineFeedbackRecord feedbackRecord;
+	feedback->Attach(pipelineCreateInfo, feedbackRecord);
+
+	VkPipeline pipeline;
+	auto linkStart = std::chrono::high_resolution_clock::now();
+	VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+	double linkMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - linkStart).count();
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to link a Graphics Pipeline from libraries!");
+	}
+	feedback->Report(feedbackRecord, optimized ? "optimized link" : "fast link");
+
+	printf("Graphics Pipeline linked (%s, %.2f ms)\n", optimized ? "optimized" : "fast", linkMs);
+	return pipeline;
+}
+
+uint32_t PipelineLibrary::GetPartCount()
+{
+	std::lock_guard<std::mutex> lock(partsMutex);
+	return static_cast<uint32_t>(parts.size());
+}
+
+void PipelineLibrary::Invalidate(const std::string& shaderFile)
+{
+	std::lock_guard<std::mutex> lock(partsMutex);
+	for (auto& bucket : partLookup)
+	{
+		std::vector<size_t>& indices = bucket.second;
+		for (size_t i = 0; i < indices.size();)
+		{
+			// Shader files of stages a part does not contain are empty in it's description
+			const PipelineDescription& partDescription = parts[indices[i]].description;
+			if (partDescription.vertexShaderFile == shaderFile || partDescription.fragmentShaderFile == shaderFile)
+			{
+				indices.erase(indices.begin() + i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+}
+
+void PipelineLibrary::Clear()
+{
+	std::lock_guard<std::mutex> lock(partsMutex);
+	for (Part& part : parts)
+	{
+		// Part could still be compiling on another thread
+		part.pipeline.wait();
+		try
+		{
+			vkDestroyPipeline(device, part.pipeline.get(), nullptr);
+		}
+		catch (const std::exception&)
+		{
+			// Failed part, nothing to destroy
+		}
+	}
+
+	parts.clear();
+	partLookup.clear();
+}
+
+void PipelineLibrary::Destroy()
+{
+	Clear();
+}
+
+PipelineLibrary::~PipelineLibrary()
+{
+}
+
+VkPipeline PipelineLibrary::GetPart(VkPipelineCache cache, const PipelineDescription& description, VkGraphicsPipelineLibraryFlagBitsEXT partFlag,
+	VkPipelineLayout pipelineLayout)
+{
+	PipelineDescription partDescription = description.GetLibraryPart(partFlag);
+
+	std::promise<VkPipeline> promise;
+	std::shared_future<VkPipeline> future;
+	bool compile = false;
+	{
+		std::lock_guard<std::mutex> lock(partsMutex);
+		std::vector<size_t>& bucket = partLookup[partDescription.Hash()];
+		for (size_t index : bucket)
+		{
+			if (parts[index].flag == partFlag && parts[index].pipelineLayout == pipelineLayout && parts[index].description == partDescription)
+			{
+				future = parts[index].pipeline;
+				break;
+			}
+		}
+
+		// First thread asking for a part compiles it, others wait for that
+		if (!future.valid())
+		{
+			Part part;
+			part.flag = partFlag;
+			part.description = partDescription;
+			part.pipelineLayout = pipelineLayout;
+			part.pipeline = promise.get_future().share();
+			future = part.pipeline;
+
+			bucket.push_back(parts.size());
+			parts.push_back(part);
+			compile = true;
+		}
+	}
+
+	// Compiled outside of lock, so other parts can be compiled at the same time
+	if (compile)
+	{
+		try
+		{
+			promise.set_value(CreatePart(cache, partDescription, partFlag, pipelineLayout));
+		}
+		catch (...)
+		{
+			promise.set_exception(std::current_exception());
+		}
+	}
+
+	return future.get();
+}
+
+VkPipeline PipelineLibrary::CreatePart(VkPipelineCache cache, const PipelineDescription& part, VkGraphicsPipelineLibraryFlagBitsEXT partFlag,
+	VkPipelineLayout pipelineLayout)
+{
+	// Parts keep what link time optimization needs, so optimized link does not start from scratch
+	VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+	libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+	libraryInfo.flags = partFlag;
+
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.pNext = &libraryInfo;
+	pipelineCreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+	pipelineCreateInfo.basePipelineIndex = -1;
+
+	// Only state of this part is filled in, rest is ignored by driver
+	std::vector<VkDynamicState> dynamicStates;
+	std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+
+	// - Vertex input interface
+	VkVertexInputBindingDescription bindingDescription = {};
+	bindingDescription.binding = 0;
+	bindingDescription.stride = part.vertexStride;
+	bindingDescription.inputRate = part.vertexInputRate;
+
+	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
+	vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
+	vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(part.vertexAttributes.size());
+	vertexInputCreateInfo.pVertexAttributeDescriptions = part.vertexAttributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = part.topology;
+	inputAssembly.primitiveRestartEnable = part.primitiveRestartEnable;
+
+	// - Pre-rasterization (viewport and scissor are always dynamic)
+	VkPipelineViewportStateCreateInfo viewPortStateCreateInfo = {};
+	viewPortStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewPortStateCreateInfo.viewportCount = 1;
+	viewPortStateCreateInfo.scissorCount = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {};
+	rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizationStateCreateInfo.polygonMode = part.polygonMode;
+	rasterizationStateCreateInfo.lineWidth = 1.0f;
+	rasterizationStateCreateInfo.cullMode = part.cullMode;
+	rasterizationStateCreateInfo.frontFace = part.frontFace;
+
+	// - Fragment shader / fragment output
+	VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo = {};
+	multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampleStateCreateInfo.rasterizationSamples = part.sampleCount;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachmentState = {};
+	colorBlendAttachmentState.colorWriteMask = part.colorWriteMask;
+	colorBlendAttachmentState.blendEnable = part.blendEnable;
+	colorBlendAttachmentState.srcColorBlendFactor = part.srcColorBlendFactor;
+	colorBlendAttachmentState.dstColorBlendFactor = part.dstColorBlendFactor;
+	colorBlendAttachmentState.colorBlendOp = part.colorBlendOp;
+	colorBlendAttachmentState.srcAlphaBlendFactor = part.srcAlphaBlendFactor;
+	colorBlendAttachmentState.dstAlphaBlendFactor = part.dstAlphaBlendFactor;
+	colorBlendAttachmentState.alphaBlendOp = part.alphaBlendOp;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo = {};
+	colorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendStateCreateInfo.attachmentCount = 1;
+	colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
+
+	switch (partFlag)
+	{
+	case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+		pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
+		pipelineCreateInfo.pInputAssemblyState = &inputAssembly;
+		if (part.dynamicStates & PIPELINE_DYNAMIC_TOPOLOGY)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+		}
+		if (part.dynamicStates & PIPELINE_DYNAMIC_PRIMITIVE_RESTART)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT);
+		}
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+		pipelineCreateInfo.pViewportState = &viewPortStateCreateInfo;
+		pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;
+		pipelineCreateInfo.layout = pipelineLayout;
+		pipelineCreateInfo.renderPass = renderPass;
+		shaderStages.resize(1);
+		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStages[0].module = shaderModules->Get(part.vertexShaderFile);
+		dynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+		dynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);
+		if (part.dynamicStates & PIPELINE_DYNAMIC_CULL_MODE)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+		}
+		if (part.dynamicStates & PIPELINE_DYNAMIC_FRONT_FACE)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+		}
+		if (part.dynamicStates & PIPELINE_DYNAMIC_POLYGON_MODE)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+		}
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+		pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
+		pipelineCreateInfo.layout = pipelineLayout;
+		pipelineCreateInfo.renderPass = renderPass;
+		shaderStages.resize(1);
+		shaderStages[0].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStages[0].module = shaderModules->Get(part.fragmentShaderFile);
+		break;
+	case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+		pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;
+		pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
+		pipelineCreateInfo.renderPass = renderPass;
+		if (part.dynamicStates & PIPELINE_DYNAMIC_BLEND)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+			dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+			dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+		}
+		break;
+	default:
+		throw std::runtime_error("Unknown Graphics Pipeline Library part!");
+	}
+
+	// Part has one shader stage at most, it's constants are part of the part's description
+	ShaderSpecialization specialization;
+	for (VkPipelineShaderStageCreateInfo& stage : shaderStages)
+	{
+		stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stage.pName = "main";
+		part.GetSpecialization(stage.stage, specialization);
+		stage.pSpecializationInfo = specialization.Get();
+	}
+	pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineCreateInfo.pStages = shaderStages.data();
+
+	VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
+	dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicStateCreateInfo.pDynamicStates = dynamicStates.data();
+	pipelineCreateInfo.pDynamicState = dynamicStates.empty() ? nullptr : &dynamicStateCreateInfo;
+
+	PipelineFeedbackRecord feedbackRecord;
+	feedback->Attach(pipelineCreateInfo, feedbackRecord);
+
+	VkPipeline pipeline;
+	auto createStart = std::chrono::high_resolution_clock::now();
+	VkResult result = vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+	double createMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - createStart).count();
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Graphics Pipeline Library part!");
+	}
+
+	printf("Graphics Pipeline Library part 0x%x compiled (%.2f ms)\n", (uint32_t)partFlag, createMs);
+	feedback->Report(feedbackRecord, "library part");
+	return pipeline;
+}
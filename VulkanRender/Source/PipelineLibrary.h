@@ -0,0 +1,69 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <future>
+
+#include "PipelineDescription.h"
+#include "PipelineFeedback.h"
+#include "ShaderModuleCache.h"
+#include "Utilities.h"
+
+// Graphics pipelines from independently compiled parts (VK_EXT_graphics_pipeline_library)
+// Vertex input, pre-rasterization, fragment shader and fragment output parts are compiled once and shared,
+// a full pipeline is then only a link of four parts: fast link for first use, link time optimized one for later
+// Safe to call from several compiler threads at once, each part is compiled by one of them only
+class PipelineLibrary
+{
+public:
+	PipelineLibrary();
+
+	// Render pass every part is made for (Clear and Init again if it is rebuilt)
+	// Creation of every part and link is reported to feedback, shader modules come from shared cache
+	void Init(VkDevice newDevice, VkRenderPass newRenderPass, PipelineFeedback* newFeedback, ShaderModuleCache* newShaderModules);
+
+	// Link pipeline for (key of) description with given layout, compiling missing parts first; throws if something fails
+	// Shader parts are only shared between pipelines of the same layout, description needs it's vertex input resolved
+	VkPipeline Link(VkPipelineCache cache, const PipelineDescription& description, VkPipelineLayout pipelineLayout, bool optimized);
+
+	uint32_t GetPartCount();
+
+	// Parts using shader file are compiled again when next asked for (old parts are destroyed by Clear)
+	void Invalidate(const std::string& shaderFile);
+
+	// Destroy all parts, pipelines linked from them stay valid
+	void Clear();
+
+	void Destroy();
+
+	~PipelineLibrary();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	PipelineFeedback* feedback = nullptr;
+	ShaderModuleCache* shaderModules = nullptr;
+
+	struct Part
+	{
+		VkGraphicsPipelineLibraryFlagBitsEXT flag;
+		PipelineDescription description;
+		VkPipelineLayout pipelineLayout;		// Only set for parts with shaders
+		std::shared_future<VkPipeline> pipeline;
+	};
+
+	std::mutex partsMutex;
+	std::deque<Part> parts;											// Guarded by partsMutex, includes invalidated parts
+	std::unordered_map<uint64_t, std::vector<size_t>> partLookup;	// Hash -> indices of valid parts, guarded by partsMutex
+
+	VkPipeline GetPart(VkPipelineCache cache, const PipelineDescription& description, VkGraphicsPipelineLibraryFlagBitsEXT partFlag,
+		VkPipelineLayout pipelineLayout);
+	VkPipeline CreatePart(VkPipelineCache cache, const PipelineDescription& part, VkGraphicsPipelineLibraryFlagBitsEXT partFlag,
+		VkPipelineLayout pipelineLayout);
+};
@@ -0,0 +1,216 @@
+#include "PipelineRegistry.h"
+
+PipelineRegistry::PipelineRegistry()
+{
+}
+
+void PipelineRegistry::Init(VkDevice newDevice, PipelineCompiler* newCompiler, const PipelineBuildFunction& newBuildFunction, bool newOptimizeInBackground)
+{
+	device = newDevice;
+	compiler = newCompiler;
+	buildFunction = newBuildFunction;
+	optimizeInBackground = newOptimizeInBackground;
+	stats = PipelineRegistryStats();
+}
+
+PipelineHandle PipelineRegistry::Get(const PipelineDescription& fullDescription)
+{
+	PipelineDescription description = fullDescription.GetPipelineKey();
+
+	std::vector<PipelineHandle>& bucket = lookup[description.Hash()];
+	for (PipelineHandle handle : bucket)
+	{
+		if (entries[handle].description == description)
+		{
+			stats.hits++;
+			return handle;
+		}
+	}
+
+	stats.misses++;
+	stats.pipelineCount++;
+
+	// Optimized build is queued behind fast one, so it never delays first use
+	Entry entry;
+	entry.description = description;
+	entry.pipeline = Submit(description, PIPELINE_BUILD_FAST);
+	if (optimizeInBackground)
+	{
+		entry.pendingPipeline = Submit(description, PIPELINE_BUILD_OPTIMIZED);
+		entry.pendingPass = PIPELINE_BUILD_OPTIMIZED;
+	}
+
+	PipelineHandle handle = static_cast<PipelineHandle>(entries.size());
+	entries.push_back(entry);
+	bucket.push_back(handle);
+
+	return handle;
+}
+
+VkPipeline PipelineRegistry::GetIfReady(PipelineHandle handle)
+{
+	if (handle >= entries.size())
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	return PipelineCompiler::GetIfReady(entries[handle].pipeline);
+}
+
+VkPipeline PipelineRegistry::Wait(PipelineHandle handle)
+{
+	return entries.at(handle).pipeline.get();
+}
+
+uint32_t PipelineRegistry::Reload(const std::string& shaderFile)
+{
+	uint32_t reloaded = 0;
+	for (Entry& entry : entries)
+	{
+		if (entry.description.vertexShaderFile != shaderFile && entry.description.fragmentShaderFile != shaderFile)
+		{
+			continue;
+		}
+
+		// Replacement built from old shader is of no use any more
+		if (entry.pendingPipeline.valid())
+		{
+			discardedPipelines.push_back(entry.pendingPipeline);
+		}
+
+		// Fast build first, so edit shows up as soon as possible (Update queues optimized one after it)
+		entry.pendingPipeline = Submit(entry.description, PIPELINE_BUILD_FAST);
+		entry.pendingPass = PIPELINE_BUILD_FAST;
+		reloaded++;
+	}
+
+	return reloaded;
+}
+
+std::vector<PipelineHandle> PipelineRegistry::Update(DeletionQueue* deletionQueue)
+{
+	VkDevice owner = device;
+	std::vector<PipelineHandle> reloaded;
+	for (PipelineHandle handle = 0; handle < entries.size(); handle++)
+	{
+		Entry& entry = entries[handle];
+		if (!PipelineCompiler::IsReady(entry.pendingPipeline) || !PipelineCompiler::IsReady(entry.pipeline))
+		{
+			continue;
+		}
+
+		// Failed build (e.g. shader edit that does not compile) just keeps current pipeline
+		PipelineFuture finished = entry.pendingPipeline;
+		PipelineBuildPass finishedPass = entry.pendingPass;
+		entry.pendingPipeline = PipelineFuture();
+
+		VkPipeline replacement = PipelineCompiler::GetIfReady(finished);
+		if (replacement == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+
+		// Frames in flight may still use replaced pipeline
+		VkPipeline replaced = PipelineCompiler::GetIfReady(entry.pipeline);
+		if (replaced != VK_NULL_HANDLE)
+		{
+			deletionQueue->Push([owner, replaced]()
+			{
+				vkDestroyPipeline(owner, replaced, nullptr);
+			});
+		}
+		entry.pipeline = finished;
+
+		if (finishedPass == PIPELINE_BUILD_OPTIMIZED)
+		{
+			stats.optimizedCount++;
+		}
+		else
+		{
+			stats.reloadCount++;
+			reloaded.push_back(handle);
+
+			// Reloaded pipeline gets it's optimized build too
+			if (optimizeInBackground)
+			{
+				entry.pendingPipeline = Submit(entry.description, PIPELINE_BUILD_OPTIMIZED);
+				entry.pendingPass = PIPELINE_BUILD_OPTIMIZED;
+			}
+		}
+	}
+
+	// Overtaken replacements were never used, nothing on GPU can reference them
+	for (size_t i = 0; i < discardedPipelines.size();)
+	{
+		if (!PipelineCompiler::IsReady(discardedPipelines[i]))
+		{
+			i++;
+			continue;
+		}
+
+		VkPipeline discarded = PipelineCompiler::GetIfReady(discardedPipelines[i]);
+		if (discarded != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(device, discarded, nullptr);
+		}
+		discardedPipelines.erase(discardedPipelines.begin() + i);
+	}
+
+	return reloaded;
+}
+
+PipelineRegistryStats PipelineRegistry::GetStats()
+{
+	return stats;
+}
+
+void PipelineRegistry::Clear()
+{
+	for (Entry& entry : entries)
+	{
+		discardedPipelines.push_back(entry.pipeline);
+		discardedPipelines.push_back(entry.pendingPipeline);
+	}
+
+	// Failed compiles have nothing to destroy
+	for (PipelineFuture& future : discardedPipelines)
+	{
+		if (!future.valid())
+		{
+			continue;
+		}
+
+		future.wait();
+		VkPipeline pipeline = PipelineCompiler::GetIfReady(future);
+		if (pipeline != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(device, pipeline, nullptr);
+		}
+	}
+
+	entries.clear();
+	lookup.clear();
+	discardedPipelines.clear();
+	stats.pipelineCount = 0;
+}
+
+void PipelineRegistry::Destroy()
+{
+	Clear();
+	printf("Pipeline registry: %u hits, %u misses, %u optimized, %u reloaded\n", stats.hits, stats.misses, stats.optimizedCount, stats.reloadCount);
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+}
+
+PipelineFuture PipelineRegistry::Submit(const PipelineDescription& description, PipelineBuildPass pass)
+{
+	// Job keeps it's own copy of description, entries may grow while it compiles
+	PipelineBuildFunction build = buildFunction;
+	return compiler->Submit(
+		[build, description, pass](VkPipelineCache cache)
+		{
+			return build(cache, description, pass);
+		});
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+
+#include "PipelineDescription.h"
+#include "PipelineCompiler.h"
+#include "DeletionQueue.h"
+
+// Registry slot of one pipeline, valid until registry is cleared
+typedef uint32_t PipelineHandle;
+
+// How a pipeline is built: fast first (usable quickly), optimized later in background if builder supports it
+enum PipelineBuildPass
+{
+	PIPELINE_BUILD_FAST,
+	PIPELINE_BUILD_OPTIMIZED,
+};
+
+// Builds a pipeline for a description (runs on a compiler thread)
+typedef std::function<VkPipeline(VkPipelineCache, const PipelineDescription&, PipelineBuildPass)> PipelineBuildFunction;
+
+struct PipelineRegistryStats
+{
+	uint32_t hits = 0;				// Lookups answered with an existing (or compiling) pipeline
+	uint32_t misses = 0;			// Lookups that queued a new compile
+	uint32_t pipelineCount = 0;
+	uint32_t optimizedCount = 0;	// Pipelines replaced by their optimized build
+	uint32_t reloadCount = 0;		// Pipelines replaced after one of their shaders changed
+};
+
+// Deduplicating pipeline registry: identical descriptions share one VkPipeline
+// Descriptions are reduced to their pipeline key first, so ones differing only in dynamic state share too
+// Lookups go by description hash (equality checked too, so a hash collision can't hand out a wrong pipeline)
+// Shaders are identified by file name, never by content:
+// - two file names with identical SPIR-V get separate pipelines (they still share one shader module)
+// - a pipeline stays built from what its shader files contained when it was built, until Reload is called for
+//   every edited file (ShaderWatcher does that in the renderer)
+// Owns every pipeline it hands out, they live until Clear (e.g. render pass rebuilt) or Destroy
+class PipelineRegistry
+{
+public:
+	PipelineRegistry();
+
+	// optimizeInBackground: after fast build, queue an optimized build that replaces it once done
+	void Init(VkDevice newDevice, PipelineCompiler* newCompiler, const PipelineBuildFunction& newBuildFunction, bool newOptimizeInBackground);
+
+	// Existing pipeline for description, or a new one queued for compilation; never blocks
+	PipelineHandle Get(const PipelineDescription& fullDescription);
+
+	// Current pipeline of handle if compiled (and not failed), otherwise VK_NULL_HANDLE; never blocks
+	VkPipeline GetIfReady(PipelineHandle handle);
+
+	// Block until pipeline of handle is compiled, throws if compile failed
+	VkPipeline Wait(PipelineHandle handle);
+
+	// Rebuild every pipeline using shader file (changed on disk), old pipelines stay in use until new ones are ready
+	// Returns number of pipelines queued for rebuild
+	uint32_t Reload(const std::string& shaderFile);
+
+	// Swap in finished optimized or reloaded pipelines, replaced ones are destroyed once GPU is done with them
+	// Returns handles that got a reloaded pipeline (its shaders, and so its layout, may have changed)
+	std::vector<PipelineHandle> Update(DeletionQueue* deletionQueue);
+
+	PipelineRegistryStats GetStats();
+
+	// Destroy all pipelines, waits for compiles in flight (GPU must be done with them)
+	void Clear();
+
+	void Destroy();
+
+	~PipelineRegistry();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	PipelineCompiler* compiler = nullptr;
+	PipelineBuildFunction buildFunction;
+	bool optimizeInBackground = false;
+
+	struct Entry
+	{
+		PipelineDescription description;
+		PipelineFuture pipeline;			// Pipeline in use
+		PipelineFuture pendingPipeline;		// Replacement still on it's way (empty if none)
+		PipelineBuildPass pendingPass = PIPELINE_BUILD_FAST;
+	};
+	std::deque<Entry> entries;										// Indexed by handle (deque keeps entries in place)
+	std::unordered_map<uint64_t, std::vector<PipelineHandle>> lookup;	// Hash -> handles of descriptions with that hash
+	std::vector<PipelineFuture> discardedPipelines;					// Replacements overtaken by a newer reload, destroyed once built
+
+	PipelineRegistryStats stats;
+
+	PipelineFuture Submit(const PipelineDescription& description, PipelineBuildPass pass);
+};
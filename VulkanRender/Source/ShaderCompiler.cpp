@@ -0,0 +1,371 @@
+#include "ShaderCompiler.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "MappedFile.h"
+
+// Bump when anything changes how SPIR-V is produced, old cache files are then ignored
+const uint32_t SHADER_CACHE_VERSION = 1;
+
+// Extension of file name (without dot), empty if none
+static std::string getExtension(const std::string& fileName)
+{
+	size_t dot = fileName.find_last_of('.');
+	size_t slash = fileName.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return "";
+	}
+	return fileName.substr(dot + 1);
+}
+
+// 64 bit FNV-1a, continued from given hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& text)
+{
+	// Length first, so "ab" + "c" and "a" + "bc" differ
+	uint64_t length = text.size();
+	hash = hashBytes(hash, &length, sizeof(length));
+	return hashBytes(hash, text.data(), text.size());
+}
+
+#ifdef USE_SHADERC
+// File of library shaderc is in (executable itself if it is linked statically), empty if it can't be found
+static std::string getCompilerModule()
+{
+#ifdef _WIN32
+	HMODULE module = nullptr;
+	if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+		reinterpret_cast<LPCSTR>(&shaderc_compile_into_spv), &module))
+	{
+		return "";
+	}
+	char path[MAX_PATH];
+	DWORD length = GetModuleFileNameA(module, path, MAX_PATH);
+	return length > 0 && length < MAX_PATH ? std::string(path, length) : "";
+#else
+	Dl_info info;
+	if (dladdr(reinterpret_cast<void*>(&shaderc_compile_into_spv), &info) == 0 || info.dli_fname == nullptr)
+	{
+		return "";
+	}
+	return info.dli_fname;
+#endif
+}
+#endif
+
+ShaderCompiler::ShaderCompiler()
+{
+}
+
+bool ShaderCompiler::IsAvailable()
+{
+#ifdef USE_SHADERC
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool ShaderCompiler::IsSource(const std::string& fileName)
+{
+	std::string extension = getExtension(fileName);
+	return extension == "vert" || extension == "frag" || extension == "comp";
+}
+
+void ShaderCompiler::Init(const std::string& newCacheDirectory)
+{
+	cacheDirectory = newCacheDirectory;
+
+	// Fails if it already exists, which is fine
+#ifdef _WIN32
+	_mkdir(cacheDirectory.c_str());
+#else
+	mkdir(cacheDirectory.c_str(), 0755);
+#endif
+
+	if (ShaderOptimizer::IsAvailable())
+	{
+		optimizer.Init();
+	}
+
+#ifdef USE_SHADERC
+	compiler = shaderc_compiler_initialize();
+	if (compiler == nullptr)
+	{
+		throw std::runtime_error("Failed to initialise Shader Compiler!");
+	}
+
+	// shaderc has no version query (shaderc_get_spv_version is the SPIR-V version it emits), so compiler build is
+	// identified by content of library it is in: upgrading shaderc or glslang changes it and old cache entries go unused
+	MappedFile compilerModule;
+	std::string compilerModuleFile = getCompilerModule();
+	if (!compilerModuleFile.empty() && compilerModule.Open(compilerModuleFile))
+	{
+		compilerKey = hashBytes(14695981039346656037ull, compilerModule.GetData(), compilerModule.GetSize());
+	}
+	else
+	{
+		// Build can't be told apart from another one, so cache entries are only reused by this run
+		printf("Shader compiler library not found, compiled shaders are cached for this run only\n");
+		int64_t startTime = std::chrono::system_clock::now().time_since_epoch().count();
+		compilerKey = hashBytes(14695981039346656037ull, &startTime, sizeof(startTime));
+	}
+#endif
+}
+
+std::string ShaderCompiler::Compile(const std::string& sourceFile, const std::vector<ShaderDefine>& defines)
+{
+	std::ifstream file(sourceFile, std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open shader source " + sourceFile + "!");
+	}
+	std::stringstream sourceStream;
+	sourceStream << file.rdbuf();
+	std::string source = sourceStream.str();
+	file.close();
+
+	std::string extension = getExtension(sourceFile);
+
+	// Cache key: everything that goes in to SPIR-V
+	uint64_t key = GetOptimizationKey();
+	key = hashString(key, extension);
+	key = hashString(key, source);
+	uint64_t defineCount = defines.size();
+	key = hashBytes(key, &defineCount, sizeof(defineCount));
+	for (const ShaderDefine& define : defines)
+	{
+		key = hashString(key, define.name);
+		key = hashString(key, define.value);
+	}
+#ifdef USE_SHADERC
+	key = hashBytes(key, &compilerKey, sizeof(compilerKey));
+#endif
+
+	// Compiled before (this run or an earlier one)
+	std::string spirvFile = GetCacheFile(sourceFile, key);
+	if (IsCached(spirvFile))
+	{
+		return spirvFile;
+	}
+
+#ifdef USE_SHADERC
+	shaderc_shader_kind kind = extension == "vert" ? shaderc_vertex_shader :
+		extension == "frag" ? shaderc_fragment_shader : shaderc_compute_shader;
+
+	// Optimizer stage does the optimizing if there is one, otherwise shaderc's own performance level is used
+	shaderc_compile_options_t options = shaderc_compile_options_initialize();
+	shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+	shaderc_compile_options_set_optimization_level(options, optimization && !ShaderOptimizer::IsAvailable() ?
+		shaderc_optimization_level_performance : shaderc_optimization_level_zero);
+	for (const ShaderDefine& define : defines)
+	{
+		shaderc_compile_options_add_macro_definition(options, define.name.c_str(), define.name.size(), define.value.c_str(), define.value.size());
+	}
+
+	auto compileStart = std::chrono::high_resolution_clock::now();
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, source.c_str(), source.size(), kind,
+		sourceFile.c_str(), "main", options);
+	double compileMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count();
+	shaderc_compile_options_release(options);
+
+	if (shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success)
+	{
+		std::string log = shaderc_result_get_error_message(result);
+		shaderc_result_release(result);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.failedCount++;
+		}
+		throw std::runtime_error("Failed to compile shader " + sourceFile + ":\n" + log);
+	}
+
+	const uint32_t* code = reinterpret_cast<const uint32_t*>(shaderc_result_get_bytes(result));
+	std::vector<uint32_t> words(code, code + shaderc_result_get_length(result) / sizeof(uint32_t));
+	shaderc_result_release(result);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.compiledCount++;
+	}
+	printf("Shader compiled: %s (%zu bytes, %.2f ms)\n", sourceFile.c_str(), words.size() * sizeof(uint32_t), compileMs);
+
+	if (IsOptimizing())
+	{
+		words = OptimizeWords(sourceFile, words.data(), words.size());
+	}
+	WriteCached(spirvFile, words);
+
+	return spirvFile;
+#else
+	throw std::runtime_error("Failed to compile shader " + sourceFile + ", built without shader compiler (USE_SHADERC)!");
+#endif
+}
+
+std::string ShaderCompiler::Optimize(const std::string& spirvFile)
+{
+	MappedFile mappedFile;
+	if (!mappedFile.Open(spirvFile))
+	{
+		throw std::runtime_error("Failed to map shader file " + spirvFile + "!");
+	}
+
+	const uint32_t* code = static_cast<const uint32_t*>(mappedFile.GetData());
+	size_t wordCount = mappedFile.GetSize() / sizeof(uint32_t);
+
+	// Keyed by content, so rebuilding the .spv gives a new cache entry
+	uint64_t key = hashBytes(GetOptimizationKey(), code, wordCount * sizeof(uint32_t));
+	std::string optimizedFile = GetCacheFile(spirvFile, key);
+	if (IsCached(optimizedFile))
+	{
+		return optimizedFile;
+	}
+
+	WriteCached(optimizedFile, OptimizeWords(spirvFile, code, wordCount));
+	return optimizedFile;
+}
+
+bool ShaderCompiler::IsOptimizing()
+{
+	return optimization && ShaderOptimizer::IsAvailable();
+}
+
+void ShaderCompiler::SetOptimization(bool enable)
+{
+	optimization = enable;
+}
+
+ShaderCompilerStats ShaderCompiler::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void ShaderCompiler::Destroy()
+{
+	optimizer.Destroy();
+#ifdef USE_SHADERC
+	if (compiler != nullptr)
+	{
+		shaderc_compiler_release(compiler);
+		compiler = nullptr;
+	}
+#endif
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+}
+
+uint64_t ShaderCompiler::GetOptimizationKey()
+{
+	uint64_t key = 14695981039346656037ull;
+	key = hashBytes(key, &SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+
+	// Optimizer stage, shaderc performance level and no optimization all give different SPIR-V
+	uint32_t mode = !optimization ? 0 : ShaderOptimizer::IsAvailable() ? 1 : 2;
+	return hashBytes(key, &mode, sizeof(mode));
+}
+
+std::string ShaderCompiler::GetCacheFile(const std::string& fileName, uint64_t key)
+{
+	size_t slash = fileName.find_last_of("/\\");
+	std::string baseName = fileName.substr(slash == std::string::npos ? 0 : slash + 1);
+	char keyString[17];
+	snprintf(keyString, sizeof(keyString), "%016llx", (unsigned long long)key);
+	return cacheDirectory + baseName + "_" + keyString + ".spv";
+}
+
+bool ShaderCompiler::IsCached(const std::string& spirvFile)
+{
+	struct stat cachedStat;
+	if (stat(spirvFile.c_str(), &cachedStat) != 0 || cachedStat.st_size == 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.cacheHits++;
+	return true;
+}
+
+void ShaderCompiler::WriteCached(const std::string& spirvFile, const std::vector<uint32_t>& words)
+{
+	// Written under temporary name (per thread) first, so a half written file is never picked up as cached SPIR-V
+	std::string temporaryFile = spirvFile + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::ofstream output(temporaryFile, std::ios::binary | std::ios::trunc);
+	output.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+	output.close();
+
+	if (!output)
+	{
+		std::remove(temporaryFile.c_str());
+		throw std::runtime_error("Failed to write compiled shader " + spirvFile + "!");
+	}
+
+	// Rename fails on Windows if another thread renamed same SPIR-V in place meanwhile, that one is just as good
+	if (std::rename(temporaryFile.c_str(), spirvFile.c_str()) != 0)
+	{
+		std::remove(temporaryFile.c_str());
+		struct stat cachedStat;
+		if (stat(spirvFile.c_str(), &cachedStat) != 0)
+		{
+			throw std::runtime_error("Failed to write compiled shader " + spirvFile + "!");
+		}
+	}
+}
+
+std::vector<uint32_t> ShaderCompiler::OptimizeWords(const std::string& fileName, const uint32_t* code, size_t wordCount)
+{
+	ShaderOptimizationResult result;
+	std::vector<uint32_t> optimized;
+	try
+	{
+		optimized = optimizer.Optimize(code, wordCount, result);
+	}
+	catch (const std::exception&)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.failedCount++;
+		throw;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.optimizedCount++;
+		stats.bytesBefore += result.bytesBefore;
+		stats.bytesAfter += result.bytesAfter;
+		stats.instructionsBefore += result.instructionsBefore;
+		stats.instructionsAfter += result.instructionsAfter;
+	}
+	printf("Shader optimized: %s (%zu -> %zu bytes, %u -> %u instructions, %.2f ms)\n", fileName.c_str(),
+		result.bytesBefore, result.bytesAfter, result.instructionsBefore, result.instructionsAfter, result.optimizeMs);
+
+	return optimized;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#ifdef USE_SHADERC
+#include "shaderc/shaderc.h"
+#endif
+
+#include "ShaderOptimizer.h"
+
+struct ShaderCompilerStats
+{
+	uint32_t compiledCount = 0;		// Sources actually run through compiler
+	uint32_t cacheHits = 0;			// SPIR-V found in disk cache
+	uint32_t failedCount = 0;
+
+	// - Optimizer stage (totals over optimized shaders, before -> after)
+	uint32_t optimizedCount = 0;
+	uint64_t bytesBefore = 0;
+	uint64_t bytesAfter = 0;
+	uint64_t instructionsBefore = 0;
+	uint64_t instructionsAfter = 0;
+};
+
+// Preprocessor define handed to compiler (as if source started with #define name value)
+struct ShaderDefine
+{
+	std::string name;
+	std::string value;
+};
+
+// Runtime GLSL -> SPIR-V compiler (shaderc, only built with USE_SHADERC) with a disk cache of compiled SPIR-V
+// Cache files are named after a hash of source text, stage, defines and compiler build,
+// so an unchanged shader is never compiled twice and editing a shader never picks up stale SPIR-V
+// Compiled SPIR-V goes through optimizer stage (if built with USE_SPIRV_TOOLS) before it is cached,
+// precompiled SPIR-V can be run through it too
+// Safe to call from several pipeline compiler threads at once
+class ShaderCompiler
+{
+public:
+	ShaderCompiler();
+
+	// Compiler built in to this executable
+	static bool IsAvailable();
+
+	// GLSL source file the compiler knows the stage of (.vert, .frag, .comp)
+	static bool IsSource(const std::string& fileName);
+
+	void Init(const std::string& newCacheDirectory);
+
+	// Compile source with defines (or find it in cache), returns file name of SPIR-V; throws with compiler log if it does not compile
+	std::string Compile(const std::string& sourceFile, const std::vector<ShaderDefine>& defines = std::vector<ShaderDefine>());
+
+	// Optimize precompiled SPIR-V file (or find it in cache), returns file name of optimized SPIR-V
+	std::string Optimize(const std::string& spirvFile);
+
+	// Optimizer stage is used (enabled and built in)
+	bool IsOptimizing();
+
+	// Turn optimizer stage on or off (on by default), e.g. to measure what it gains; cache keeps both versions
+	void SetOptimization(bool enable);
+
+	ShaderCompilerStats GetStats();
+
+	void Destroy();
+
+	~ShaderCompiler();
+
+private:
+	std::string cacheDirectory;
+	bool optimization = true;
+	ShaderOptimizer optimizer;
+
+	std::mutex mutex;											// Guards stats
+	ShaderCompilerStats stats;
+
+#ifdef USE_SHADERC
+	shaderc_compiler_t compiler = nullptr;						// Thread safe, shared by all compiles
+	uint64_t compilerKey = 0;									// Identifies compiler build, part of every cache key
+#endif
+
+	uint64_t GetOptimizationKey();
+	std::string GetCacheFile(const std::string& fileName, uint64_t key);
+	bool IsCached(const std::string& spirvFile);
+	void WriteCached(const std::string& spirvFile, const std::vector<uint32_t>& words);
+	std::vector<uint32_t> OptimizeWords(const std::string& fileName, const uint32_t* code, size_t wordCount);
+};
@@ -0,0 +1,256 @@
+#include "ShaderModuleCache.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "MappedFile.h"
+
+const uint32_t SPIRV_MAGIC = 0x07230203;
+
+// Size and modification time of file, false if it does not exist
+// Time has the file system's full resolution (st_mtime's whole seconds would miss two quick edits of same size)
+static bool getFileStamp(const std::string& fileName, int64_t& modifiedTime, uint64_t& size)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileName.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return false;
+	}
+
+	// 100 ns ticks
+	modifiedTime = static_cast<int64_t>((static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime);
+	size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+#else
+	struct stat fileStat;
+	if (stat(fileName.c_str(), &fileStat) != 0)
+	{
+		return false;
+	}
+
+	// Nanoseconds
+#ifdef __APPLE__
+	modifiedTime = static_cast<int64_t>(fileStat.st_mtimespec.tv_sec) * 1000000000 + fileStat.st_mtimespec.tv_nsec;
+#else
+	modifiedTime = static_cast<int64_t>(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+#endif
+	size = static_cast<uint64_t>(fileStat.st_size);
+#endif
+	return true;
+}
+
+// 64 bit FNV-1a over SPIR-V words (code size is always a multiple of 4)
+static uint64_t hashWords(const uint32_t* words, size_t wordCount)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < wordCount; i++)
+	{
+		hash ^= words[i];
+		hash *= 1099511628211ull;
+	}
+	hash ^= wordCount;
+	hash *= 1099511628211ull;
+	return hash;
+}
+
+ShaderModuleCache::ShaderModuleCache()
+{
+}
+
+void ShaderModuleCache::Init(VkDevice newDevice, ShaderCompiler* newCompiler)
+{
+	device = newDevice;
+	compiler = newCompiler;
+}
+
+VkShaderModule ShaderModuleCache::Get(const std::string& fileName)
+{
+	int64_t modifiedTime = 0;
+	uint64_t size = 0;
+	if (!getFileStamp(fileName, modifiedTime, size))
+	{
+		throw std::runtime_error("Failed to open shader file " + fileName + "!");
+	}
+
+	// Unchanged file, module is already there
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto file = files.find(fileName);
+		if (file != files.end() && file->second.modifiedTime == modifiedTime && file->second.size == size)
+		{
+			auto module = modules.find(file->second.contentHash);
+			if (module != modules.end())
+			{
+				stats.fileHits++;
+				return module->second;
+			}
+		}
+	}
+
+	// Compiling, mapping and hashing happen outside of lock, other threads can look up modules meanwhile
+	std::string spirvFile = fileName;
+	if (ShaderCompiler::IsSource(fileName))
+	{
+		if (compiler == nullptr)
+		{
+			throw std::runtime_error("Failed to load shader " + fileName + ", no shader compiler for GLSL sources!");
+		}
+		spirvFile = compiler->Compile(fileName);
+	}
+	else if (compiler != nullptr && compiler->IsOptimizing())
+	{
+		spirvFile = compiler->Optimize(fileName);
+	}
+
+	MappedFile mappedFile;
+	if (!mappedFile.Open(spirvFile))
+	{
+		throw std::runtime_error("Failed to map shader file " + spirvFile + "!");
+	}
+
+	const uint32_t* code = static_cast<const uint32_t*>(mappedFile.GetData());
+	size_t codeSize = mappedFile.GetSize();
+	if (codeSize % sizeof(uint32_t) != 0 || codeSize < 5 * sizeof(uint32_t) || code[0] != SPIRV_MAGIC)
+	{
+		throw std::runtime_error("Shader file " + spirvFile + " is not SPIR-V!");
+	}
+
+	uint64_t contentHash = hashWords(code, codeSize / sizeof(uint32_t));
+	ShaderReflection reflection = ShaderReflection::Reflect(code, codeSize / sizeof(uint32_t));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.filesMapped++;
+
+	// Module of file's old content is retired if no other file still has that content
+	auto previousFile = files.find(fileName);
+	if (previousFile != files.end() && previousFile->second.contentHash != contentHash)
+	{
+		uint64_t previousHash = previousFile->second.contentHash;
+		previousFile->second.contentHash = contentHash;
+		Supersede(previousHash);
+	}
+
+	FileEntry& file = files[fileName];
+	file.modifiedTime = modifiedTime;
+	file.size = size;
+	file.contentHash = contentHash;
+
+	auto module = modules.find(contentHash);
+	if (module != modules.end())
+	{
+		stats.contentHits++;
+		return module->second;
+	}
+
+	// Created while holding lock, so two threads never create the same module
+	VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shaderModuleCreateInfo.codeSize = codeSize;
+	shaderModuleCreateInfo.pCode = code;
+
+	VkShaderModule shaderModule;
+	VkResult result = vkCreateShaderModule(device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Shader Module!");
+	}
+
+	modules[contentHash] = shaderModule;
+	reflections[shaderModule] = reflection;
+	stats.moduleCount++;
+	printf("Shader module created: %s (%zu bytes, %u instructions, hash %016llx)\n", fileName.c_str(), codeSize,
+		ShaderOptimizer::CountInstructions(code, codeSize / sizeof(uint32_t)), (unsigned long long)contentHash);
+
+	return shaderModule;
+}
+
+const ShaderReflection& ShaderModuleCache::GetReflection(VkShaderModule shaderModule)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto reflection = reflections.find(shaderModule);
+	if (reflection == reflections.end())
+	{
+		throw std::runtime_error("Failed to find reflection of Shader Module!");
+	}
+	return reflection->second;
+}
+
+void ShaderModuleCache::Invalidate(const std::string& fileName)
+{
+	// Content hash is kept, so next Get can tell if old module was replaced
+	std::lock_guard<std::mutex> lock(mutex);
+	auto file = files.find(fileName);
+	if (file != files.end())
+	{
+		file->second.modifiedTime = -1;
+	}
+}
+
+void ShaderModuleCache::ReleaseSuperseded(DeletionQueue* deletionQueue)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	VkDevice owner = device;
+	for (VkShaderModule shaderModule : supersededModules)
+	{
+		reflections.erase(shaderModule);
+		deletionQueue->Push([owner, shaderModule]()
+		{
+			vkDestroyShaderModule(owner, shaderModule, nullptr);
+		});
+	}
+	stats.moduleCount -= static_cast<uint32_t>(supersededModules.size());
+	supersededModules.clear();
+}
+
+ShaderModuleCacheStats ShaderModuleCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void ShaderModuleCache::Destroy()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& module : modules)
+	{
+		vkDestroyShaderModule(device, module.second, nullptr);
+	}
+	for (VkShaderModule shaderModule : supersededModules)
+	{
+		vkDestroyShaderModule(device, shaderModule, nullptr);
+	}
+	modules.clear();
+	supersededModules.clear();
+	reflections.clear();
+	files.clear();
+	stats = ShaderModuleCacheStats();
+}
+
+ShaderModuleCache::~ShaderModuleCache()
+{
+}
+
+void ShaderModuleCache::Supersede(uint64_t contentHash)
+{
+	for (auto& file : files)
+	{
+		if (file.second.contentHash == contentHash)
+		{
+			return;
+		}
+	}
+
+	auto module = modules.find(contentHash);
+	if (module != modules.end())
+	{
+		supersededModules.push_back(module->second);
+		modules.erase(module);
+	}
+}
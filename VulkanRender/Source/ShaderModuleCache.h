@@ -0,0 +1,80 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+#include "DeletionQueue.h"
+
+struct ShaderModuleCacheStats
+{
+	uint32_t moduleCount = 0;
+	uint32_t fileHits = 0;			// File unchanged since last lookup, not even mapped
+	uint32_t contentHits = 0;		// File mapped, but same SPIR-V as an existing module (e.g. copied file)
+	uint32_t filesMapped = 0;
+};
+
+// Shader modules keyed by hash of their SPIR-V, shared by every pipeline using them
+// SPIR-V is memory mapped straight from file and handed to driver from the mapping (no copy, always word aligned)
+// Files are only mapped again if their size or modification time changed
+// A module whose file changed (and no other file has its content) is retired, see ReleaseSuperseded
+// GLSL sources are compiled first if a shader compiler is given (compiled SPIR-V comes from it's disk cache)
+// Every module is reflected once when created, so layouts can be derived from it
+// Safe to call from several compiler threads at once
+class ShaderModuleCache
+{
+public:
+	ShaderModuleCache();
+
+	void Init(VkDevice newDevice, ShaderCompiler* newCompiler = nullptr);
+
+	// Module for SPIR-V (or GLSL source) file, created on first use; throws if file is missing, does not compile or is not SPIR-V
+	VkShaderModule Get(const std::string& fileName);
+
+	// Interface of a module returned by Get (reference stays valid until module is released)
+	const ShaderReflection& GetReflection(VkShaderModule shaderModule);
+
+	// Next Get looks at file again even if it's time stamp did not change
+	// (module of old content stays until released, pipelines may still be built from it)
+	void Invalidate(const std::string& fileName);
+
+	// Hand modules of replaced file content to deletion queue
+	// Only call while no pipeline build is running or queued, those may still use an old module
+	void ReleaseSuperseded(DeletionQueue* deletionQueue);
+
+	ShaderModuleCacheStats GetStats();
+
+	// Destroy all modules (pipelines made from them stay valid)
+	void Destroy();
+
+	~ShaderModuleCache();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	ShaderCompiler* compiler = nullptr;
+
+	// What a file contained last time it was looked at
+	struct FileEntry
+	{
+		int64_t modifiedTime = 0;
+		uint64_t size = 0;
+		uint64_t contentHash = 0;
+	};
+
+	std::mutex mutex;												// Guards everything below
+	std::unordered_map<std::string, FileEntry> files;
+	std::unordered_map<uint64_t, VkShaderModule> modules;			// Content hash -> module
+	std::vector<VkShaderModule> supersededModules;					// Content no file has anymore, waiting to be released
+	std::unordered_map<VkShaderModule, ShaderReflection> reflections;
+	ShaderModuleCacheStats stats;
+
+	// Retire module of content if no file has it anymore (lock held)
+	void Supersede(uint64_t contentHash);
+};
@@ -0,0 +1,123 @@
+#include "ShaderOptimizer.h"
+
+#include <cstdio>
+#include <chrono>
+#include <string>
+
+#ifdef USE_SPIRV_TOOLS
+// Messages of run in progress (consumer has no user data, runs are serialised by mutex)
+static std::string optimizerMessages;
+
+static void collectMessage(spv_message_level_t level, const char* source, const spv_position_t* position, const char* message)
+{
+	if (level <= SPV_MSG_ERROR)
+	{
+		optimizerMessages += message;
+		optimizerMessages += "\n";
+	}
+}
+#endif
+
+ShaderOptimizer::ShaderOptimizer()
+{
+}
+
+bool ShaderOptimizer::IsAvailable()
+{
+#ifdef USE_SPIRV_TOOLS
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint32_t ShaderOptimizer::CountInstructions(const uint32_t* code, size_t wordCount)
+{
+	// Word count of each instruction is in it's upper 16 bits, header is 5 words
+	uint32_t count = 0;
+	for (size_t offset = 5; offset < wordCount; count++)
+	{
+		uint32_t instructionWords = code[offset] >> 16;
+		if (instructionWords == 0)
+		{
+			break;
+		}
+		offset += instructionWords;
+	}
+	return count;
+}
+
+void ShaderOptimizer::Init()
+{
+#ifdef USE_SPIRV_TOOLS
+	optimizer = spvOptimizerCreate(SPV_ENV_VULKAN_1_2);
+	if (optimizer == nullptr)
+	{
+		throw std::runtime_error("Failed to create SPIR-V Optimizer!");
+	}
+	spvOptimizerSetMessageConsumer(optimizer, collectMessage);
+
+	// Same recipe as spirv-opt -O, debug info (names, source lines) is of no use to driver
+	spvOptimizerRegisterPerformancePasses(optimizer);
+	const char* stripFlags[] = { "--strip-debug" };
+	if (!spvOptimizerRegisterPassesFromFlags(optimizer, stripFlags, 1))
+	{
+		throw std::runtime_error("Failed to register SPIR-V Optimizer passes!");
+	}
+
+	// Input comes from compiler or SDK tools, skip validating it again
+	options = spvOptimizerOptionsCreate();
+	spvOptimizerOptionsSetRunValidator(options, false);
+#endif
+}
+
+std::vector<uint32_t> ShaderOptimizer::Optimize(const uint32_t* code, size_t wordCount, ShaderOptimizationResult& result)
+{
+	result = ShaderOptimizationResult();
+	result.bytesBefore = wordCount * sizeof(uint32_t);
+	result.instructionsBefore = CountInstructions(code, wordCount);
+
+#ifdef USE_SPIRV_TOOLS
+	std::lock_guard<std::mutex> lock(mutex);
+
+	optimizerMessages.clear();
+	spv_binary optimized = nullptr;
+	auto optimizeStart = std::chrono::high_resolution_clock::now();
+	spv_result_t status = spvOptimizerRun(optimizer, code, wordCount, &optimized, options);
+	result.optimizeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - optimizeStart).count();
+	if (status != SPV_SUCCESS || optimized == nullptr)
+	{
+		spvBinaryDestroy(optimized);
+		throw std::runtime_error("Failed to optimize SPIR-V:\n" + optimizerMessages);
+	}
+
+	std::vector<uint32_t> words(optimized->code, optimized->code + optimized->wordCount);
+	spvBinaryDestroy(optimized);
+
+	result.bytesAfter = words.size() * sizeof(uint32_t);
+	result.instructionsAfter = CountInstructions(words.data(), words.size());
+	return words;
+#else
+	throw std::runtime_error("Failed to optimize SPIR-V, built without optimizer (USE_SPIRV_TOOLS)!");
+#endif
+}
+
+void ShaderOptimizer::Destroy()
+{
+#ifdef USE_SPIRV_TOOLS
+	if (options != nullptr)
+	{
+		spvOptimizerOptionsDestroy(options);
+		options = nullptr;
+	}
+	if (optimizer != nullptr)
+	{
+		spvOptimizerDestroy(optimizer);
+		optimizer = nullptr;
+	}
+#endif
+}
+
+ShaderOptimizer::~ShaderOptimizer()
+{
+}
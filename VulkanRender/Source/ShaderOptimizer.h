@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+#include <mutex>
+
+#ifdef USE_SPIRV_TOOLS
+#include "spirv-tools/libspirv.h"
+#endif
+
+// Size of one shader before and after optimization
+struct ShaderOptimizationResult
+{
+	size_t bytesBefore = 0;
+	size_t bytesAfter = 0;
+	uint32_t instructionsBefore = 0;
+	uint32_t instructionsAfter = 0;
+	double optimizeMs = 0.0;
+};
+
+// SPIR-V optimizer (SPIRV-Tools, only built with USE_SPIRV_TOOLS): performance recipe
+// (inlining, constant folding, dead code elimination...) followed by stripping debug info
+// Safe to call from several threads, runs are serialised
+class ShaderOptimizer
+{
+public:
+	ShaderOptimizer();
+
+	// Optimizer built in to this executable
+	static bool IsAvailable();
+
+	// Instructions in SPIR-V module (header not counted)
+	static uint32_t CountInstructions(const uint32_t* code, size_t wordCount);
+
+	void Init();
+
+	// Optimized copy of SPIR-V; throws with optimizer messages if module is rejected
+	std::vector<uint32_t> Optimize(const uint32_t* code, size_t wordCount, ShaderOptimizationResult& result);
+
+	void Destroy();
+
+	~ShaderOptimizer();
+
+private:
+	std::mutex mutex;						// Optimizer object is not safe to run from two threads at once
+
+#ifdef USE_SPIRV_TOOLS
+	spv_optimizer_t* optimizer = nullptr;
+	spv_optimizer_options options = nullptr;
+#endif
+};
@@ -0,0 +1,415 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+
+// SPIR-V opcodes, decorations and storage classes used below (SPIR-V specification, section 3)
+const uint32_t SPIRV_OP_ENTRY_POINT = 15;
+const uint32_t SPIRV_OP_TYPE_BOOL = 20;
+const uint32_t SPIRV_OP_TYPE_INT = 21;
+const uint32_t SPIRV_OP_TYPE_FLOAT = 22;
+const uint32_t SPIRV_OP_TYPE_VECTOR = 23;
+const uint32_t SPIRV_OP_TYPE_MATRIX = 24;
+const uint32_t SPIRV_OP_TYPE_IMAGE = 25;
+const uint32_t SPIRV_OP_TYPE_SAMPLER = 26;
+const uint32_t SPIRV_OP_TYPE_SAMPLED_IMAGE = 27;
+const uint32_t SPIRV_OP_TYPE_ARRAY = 28;
+const uint32_t SPIRV_OP_TYPE_RUNTIME_ARRAY = 29;
+const uint32_t SPIRV_OP_TYPE_STRUCT = 30;
+const uint32_t SPIRV_OP_TYPE_POINTER = 32;
+const uint32_t SPIRV_OP_CONSTANT = 43;
+const uint32_t SPIRV_OP_VARIABLE = 59;
+const uint32_t SPIRV_OP_DECORATE = 71;
+const uint32_t SPIRV_OP_MEMBER_DECORATE = 72;
+
+const uint32_t SPIRV_DECORATION_BLOCK = 2;
+const uint32_t SPIRV_DECORATION_BUFFER_BLOCK = 3;
+const uint32_t SPIRV_DECORATION_ROW_MAJOR = 4;
+const uint32_t SPIRV_DECORATION_ARRAY_STRIDE = 6;
+const uint32_t SPIRV_DECORATION_MATRIX_STRIDE = 7;
+const uint32_t SPIRV_DECORATION_BUILT_IN = 11;
+const uint32_t SPIRV_DECORATION_LOCATION = 30;
+const uint32_t SPIRV_DECORATION_BINDING = 33;
+const uint32_t SPIRV_DECORATION_DESCRIPTOR_SET = 34;
+const uint32_t SPIRV_DECORATION_OFFSET = 35;
+
+const uint32_t SPIRV_STORAGE_UNIFORM_CONSTANT = 0;
+const uint32_t SPIRV_STORAGE_INPUT = 1;
+const uint32_t SPIRV_STORAGE_UNIFORM = 2;
+const uint32_t SPIRV_STORAGE_PUSH_CONSTANT = 9;
+const uint32_t SPIRV_STORAGE_STORAGE_BUFFER = 12;
+
+const uint32_t SPIRV_DIM_BUFFER = 5;
+const uint32_t SPIRV_DIM_SUBPASS_DATA = 6;
+
+const uint32_t NOT_SET = 0xFFFFFFFF;
+
+// What is known about one SPIR-V id
+struct SpirvId
+{
+	uint32_t opcode = 0;
+	std::vector<uint32_t> operands;			// Operands after result id
+	uint32_t location = NOT_SET;
+	uint32_t binding = NOT_SET;
+	uint32_t set = NOT_SET;
+	uint32_t arrayStride = 0;
+	bool block = false;
+	bool bufferBlock = false;
+	bool builtIn = false;
+	std::vector<uint32_t> memberOffsets;		// Struct only
+	std::vector<uint32_t> memberMatrixStrides;	// Struct only
+	std::vector<uint32_t> memberRowMajor;		// Struct only, 1 for matrices laid out by rows
+};
+
+// Parsed module, ids indexed directly (bound from header)
+struct SpirvModule
+{
+	std::vector<SpirvId> ids;
+
+	SpirvId& Id(uint32_t id)
+	{
+		if (id >= ids.size())
+		{
+			throw std::runtime_error("Failed to reflect shader, SPIR-V id out of bounds!");
+		}
+		return ids[id];
+	}
+
+	uint32_t Operand(uint32_t id, size_t index)
+	{
+		SpirvId& spirvId = Id(id);
+		if (index >= spirvId.operands.size())
+		{
+			throw std::runtime_error("Failed to reflect shader, SPIR-V instruction too short!");
+		}
+		return spirvId.operands[index];
+	}
+
+	// Bytes of type in a buffer block (uses offset and stride decorations)
+	// Matrix stride is the distance between columns, or between rows of a row major matrix
+	uint32_t TypeSize(uint32_t typeId, uint32_t matrixStride = 0, bool rowMajor = false)
+	{
+		SpirvId& type = Id(typeId);
+		switch (type.opcode)
+		{
+		case SPIRV_OP_TYPE_BOOL:
+			return 4;
+		case SPIRV_OP_TYPE_INT:
+		case SPIRV_OP_TYPE_FLOAT:
+			return Operand(typeId, 0) / 8;
+		case SPIRV_OP_TYPE_VECTOR:
+			return TypeSize(Operand(typeId, 0)) * Operand(typeId, 1);
+		case SPIRV_OP_TYPE_MATRIX:
+		{
+			uint32_t columnTypeId = Operand(typeId, 0);
+			if (matrixStride > 0 && rowMajor)
+			{
+				return matrixStride * Operand(columnTypeId, 1);
+			}
+			uint32_t columnSize = matrixStride > 0 ? matrixStride : TypeSize(columnTypeId);
+			return columnSize * Operand(typeId, 1);
+		}
+		case SPIRV_OP_TYPE_ARRAY:
+		{
+			uint32_t elementSize = type.arrayStride > 0 ? type.arrayStride : TypeSize(Operand(typeId, 0), matrixStride, rowMajor);
+			return elementSize * ArrayLength(typeId);
+		}
+		case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+			return 0;
+		case SPIRV_OP_TYPE_STRUCT:
+		{
+			// End of member reaching furthest, members need not be in offset order
+			uint32_t size = 0;
+			for (size_t i = 0; i < type.operands.size(); i++)
+			{
+				uint32_t offset = i < type.memberOffsets.size() && type.memberOffsets[i] != NOT_SET ? type.memberOffsets[i] : size;
+				uint32_t memberMatrixStride = i < type.memberMatrixStrides.size() && type.memberMatrixStrides[i] != NOT_SET ? type.memberMatrixStrides[i] : 0;
+				bool memberRowMajor = i < type.memberRowMajor.size() && type.memberRowMajor[i] == 1;
+				size = std::max(size, offset + TypeSize(type.operands[i], memberMatrixStride, memberRowMajor));
+			}
+			return size;
+		}
+		default:
+			throw std::runtime_error("Failed to reflect shader, unsupported type in buffer block!");
+		}
+	}
+
+	// Length of OpTypeArray (length is id of a constant)
+	uint32_t ArrayLength(uint32_t arrayTypeId)
+	{
+		uint32_t lengthId = Operand(arrayTypeId, 1);
+		if (Id(lengthId).opcode != SPIRV_OP_CONSTANT)
+		{
+			throw std::runtime_error("Failed to reflect shader, array length is not a constant!");
+		}
+		return Operand(lengthId, 1);
+	}
+};
+
+static void setMember(std::vector<uint32_t>& members, uint32_t member, uint32_t value)
+{
+	if (members.size() <= member)
+	{
+		members.resize(member + 1, NOT_SET);
+	}
+	members[member] = value;
+}
+
+static VkShaderStageFlagBits stageOfExecutionModel(uint32_t executionModel)
+{
+	switch (executionModel)
+	{
+	case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+	case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+	case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+	case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+	case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+	default:
+		throw std::runtime_error("Failed to reflect shader, unsupported execution model!");
+	}
+}
+
+// Format of a 32 bit scalar or vector input
+static VkFormat inputFormat(SpirvModule& module, uint32_t typeId, uint32_t& size)
+{
+	uint32_t componentCount = 1;
+	uint32_t componentTypeId = typeId;
+	if (module.Id(typeId).opcode == SPIRV_OP_TYPE_VECTOR)
+	{
+		componentTypeId = module.Operand(typeId, 0);
+		componentCount = module.Operand(typeId, 1);
+	}
+
+	SpirvId& component = module.Id(componentTypeId);
+	if ((component.opcode != SPIRV_OP_TYPE_FLOAT && component.opcode != SPIRV_OP_TYPE_INT) || module.Operand(componentTypeId, 0) != 32
+		|| componentCount < 1 || componentCount > 4)
+	{
+		throw std::runtime_error("Failed to reflect shader, only 32 bit scalar and vector inputs are supported!");
+	}
+	size = 4 * componentCount;
+
+	static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+	static const VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+	static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+	if (component.opcode == SPIRV_OP_TYPE_FLOAT)
+	{
+		return floatFormats[componentCount - 1];
+	}
+	return module.Operand(componentTypeId, 1) != 0 ? intFormats[componentCount - 1] : uintFormats[componentCount - 1];
+}
+
+// Descriptor type of a variable in a descriptor set, strips arrays off type (counting descriptors)
+static VkDescriptorType descriptorType(SpirvModule& module, uint32_t storageClass, uint32_t typeId, uint32_t& descriptorCount)
+{
+	descriptorCount = 1;
+	while (module.Id(typeId).opcode == SPIRV_OP_TYPE_ARRAY || module.Id(typeId).opcode == SPIRV_OP_TYPE_RUNTIME_ARRAY)
+	{
+		if (module.Id(typeId).opcode == SPIRV_OP_TYPE_ARRAY)
+		{
+			descriptorCount *= module.ArrayLength(typeId);
+		}
+		typeId = module.Operand(typeId, 0);
+	}
+
+	SpirvId& type = module.Id(typeId);
+	if (storageClass == SPIRV_STORAGE_STORAGE_BUFFER || (storageClass == SPIRV_STORAGE_UNIFORM && type.bufferBlock))
+	{
+		return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	}
+	if (storageClass == SPIRV_STORAGE_UNIFORM)
+	{
+		return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	}
+
+	switch (type.opcode)
+	{
+	case SPIRV_OP_TYPE_SAMPLER:
+		return VK_DESCRIPTOR_TYPE_SAMPLER;
+	case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	case SPIRV_OP_TYPE_IMAGE:
+	{
+		// Operands: sampled type, dim, depth, arrayed, multisampled, sampled (1 = with sampler, 2 = storage)
+		uint32_t dim = module.Operand(typeId, 1);
+		bool storage = module.Operand(typeId, 5) == 2;
+		if (dim == SPIRV_DIM_BUFFER)
+		{
+			return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+		}
+		if (dim == SPIRV_DIM_SUBPASS_DATA)
+		{
+			return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		}
+		return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	}
+	default:
+		throw std::runtime_error("Failed to reflect shader, unsupported descriptor type!");
+	}
+}
+
+ShaderReflection ShaderReflection::Reflect(const uint32_t* code, size_t wordCount)
+{
+	if (wordCount < 5)
+	{
+		throw std::runtime_error("Failed to reflect shader, SPIR-V too short!");
+	}
+
+	SpirvModule module;
+	module.ids.resize(code[3]);			// Header: magic, version, generator, id bound, schema
+
+	ShaderReflection reflection;
+	bool hasEntryPoint = false;
+	std::vector<uint32_t> variables;
+
+	// Single pass collecting types, decorations and variables (all of them come before function bodies)
+	for (size_t offset = 5; offset < wordCount;)
+	{
+		uint32_t opcode = code[offset] & 0xFFFF;
+		uint32_t instructionWords = code[offset] >> 16;
+		if (instructionWords == 0 || offset + instructionWords > wordCount)
+		{
+			throw std::runtime_error("Failed to reflect shader, malformed SPIR-V instruction!");
+		}
+		const uint32_t* operands = code + offset + 1;
+		uint32_t operandCount = instructionWords - 1;
+
+		switch (opcode)
+		{
+		case SPIRV_OP_ENTRY_POINT:
+			if (!hasEntryPoint && operandCount >= 1)
+			{
+				reflection.stage = stageOfExecutionModel(operands[0]);
+				hasEntryPoint = true;
+			}
+			break;
+		case SPIRV_OP_DECORATE:
+			if (operandCount >= 2)
+			{
+				SpirvId& target = module.Id(operands[0]);
+				uint32_t value = operandCount >= 3 ? operands[2] : 0;
+				switch (operands[1])
+				{
+				case SPIRV_DECORATION_BLOCK: target.block = true; break;
+				case SPIRV_DECORATION_BUFFER_BLOCK: target.bufferBlock = true; break;
+				case SPIRV_DECORATION_ARRAY_STRIDE: target.arrayStride = value; break;
+				case SPIRV_DECORATION_BUILT_IN: target.builtIn = true; break;
+				case SPIRV_DECORATION_LOCATION: target.location = value; break;
+				case SPIRV_DECORATION_BINDING: target.binding = value; break;
+				case SPIRV_DECORATION_DESCRIPTOR_SET: target.set = value; break;
+				default: break;
+				}
+			}
+			break;
+		case SPIRV_OP_MEMBER_DECORATE:
+			if (operandCount >= 3)
+			{
+				SpirvId& target = module.Id(operands[0]);
+				uint32_t value = operandCount >= 4 ? operands[3] : 0;
+				switch (operands[2])
+				{
+				case SPIRV_DECORATION_OFFSET: setMember(target.memberOffsets, operands[1], value); break;
+				case SPIRV_DECORATION_MATRIX_STRIDE: setMember(target.memberMatrixStrides, operands[1], value); break;
+				case SPIRV_DECORATION_ROW_MAJOR: setMember(target.memberRowMajor, operands[1], 1); break;
+				case SPIRV_DECORATION_BUILT_IN: target.builtIn = true; break;		// Block of built-ins (gl_PerVertex)
+				default: break;
+				}
+			}
+			break;
+		case SPIRV_OP_TYPE_BOOL:
+		case SPIRV_OP_TYPE_INT:
+		case SPIRV_OP_TYPE_FLOAT:
+		case SPIRV_OP_TYPE_VECTOR:
+		case SPIRV_OP_TYPE_MATRIX:
+		case SPIRV_OP_TYPE_IMAGE:
+		case SPIRV_OP_TYPE_SAMPLER:
+		case SPIRV_OP_TYPE_SAMPLED_IMAGE:
+		case SPIRV_OP_TYPE_ARRAY:
+		case SPIRV_OP_TYPE_RUNTIME_ARRAY:
+		case SPIRV_OP_TYPE_STRUCT:
+		case SPIRV_OP_TYPE_POINTER:
+			if (operandCount >= 1)
+			{
+				SpirvId& type = module.Id(operands[0]);
+				type.opcode = opcode;
+				type.operands.assign(operands + 1, operands + operandCount);
+			}
+			break;
+		case SPIRV_OP_CONSTANT:
+		case SPIRV_OP_VARIABLE:
+			// Result type comes before result id here
+			if (operandCount >= 3)
+			{
+				SpirvId& value = module.Id(operands[1]);
+				value.opcode = opcode;
+				value.operands.assign({ operands[0], operands[2] });
+				if (opcode == SPIRV_OP_VARIABLE)
+				{
+					variables.push_back(operands[1]);
+				}
+			}
+			break;
+		default:
+			break;
+		}
+
+		offset += instructionWords;
+	}
+
+	if (!hasEntryPoint)
+	{
+		throw std::runtime_error("Failed to reflect shader, SPIR-V has no entry point!");
+	}
+
+	for (uint32_t variableId : variables)
+	{
+		SpirvId& variable = module.Id(variableId);
+		uint32_t pointerTypeId = variable.operands[0];
+		uint32_t storageClass = variable.operands[1];
+		uint32_t typeId = module.Operand(pointerTypeId, 1);		// Pointer: storage class, pointee type
+
+		switch (storageClass)
+		{
+		case SPIRV_STORAGE_INPUT:
+		{
+			// Only vertex inputs become attributes, built-ins (gl_VertexIndex...) come from nowhere
+			if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn || module.Id(typeId).builtIn || variable.location == NOT_SET)
+			{
+				break;
+			}
+
+			ShaderInput input;
+			input.location = variable.location;
+			input.format = inputFormat(module, typeId, input.size);
+			reflection.inputs.push_back(input);
+			break;
+		}
+		case SPIRV_STORAGE_UNIFORM_CONSTANT:
+		case SPIRV_STORAGE_UNIFORM:
+		case SPIRV_STORAGE_STORAGE_BUFFER:
+		{
+			ShaderBinding binding;
+			binding.set = variable.set == NOT_SET ? 0 : variable.set;
+			binding.binding = variable.binding == NOT_SET ? 0 : variable.binding;
+			binding.descriptorType = descriptorType(module, storageClass, typeId, binding.descriptorCount);
+			reflection.bindings.push_back(binding);
+			break;
+		}
+		case SPIRV_STORAGE_PUSH_CONSTANT:
+			reflection.pushConstantSize = std::max(reflection.pushConstantSize, module.TypeSize(typeId));
+			break;
+		default:
+			break;
+		}
+	}
+
+	std::sort(reflection.inputs.begin(), reflection.inputs.end(), [](const ShaderInput& a, const ShaderInput& b)
+	{
+		return a.location < b.location;
+	});
+	std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b)
+	{
+		return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+	});
+
+	return reflection;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+
+// Input variable of a shader (only vertex inputs are of interest), built-ins are left out
+struct ShaderInput
+{
+	uint32_t location = 0;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t size = 0;					// Bytes read from vertex
+};
+
+// Resource a shader accesses through a descriptor set
+struct ShaderBinding
+{
+	uint32_t set = 0;
+	uint32_t binding = 0;
+	VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uint32_t descriptorCount = 1;		// Array size (runtime sized arrays count as 1)
+};
+
+// Interface of one shader module read from it's SPIR-V: inputs, descriptor bindings and push constants
+// Enough to build vertex input state and pipeline layout without writing them out by hand
+struct ShaderReflection
+{
+	VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+	std::vector<ShaderInput> inputs;		// Sorted by location
+	std::vector<ShaderBinding> bindings;	// Sorted by set, then binding
+	uint32_t pushConstantSize = 0;			// Bytes of push constant block (0 = none)
+
+	// Parse SPIR-V (first entry point only), throws if it is malformed or uses something not handled here
+	static ShaderReflection Reflect(const uint32_t* code, size_t wordCount);
+};
@@ -0,0 +1,194 @@
+#include "ShaderWatcher.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// How often watch thread checks if it should stop
+const int SHADER_WATCH_POLL_MS = 100;
+
+// Shader sources and compiled SPIR-V, editors' temporary files are ignored
+static bool isShaderFile(const std::string& name)
+{
+	size_t dot = name.find_last_of('.');
+	if (dot == std::string::npos)
+	{
+		return false;
+	}
+
+	std::string extension = name.substr(dot + 1);
+	return extension == "vert" || extension == "frag" || extension == "comp" || extension == "spv";
+}
+
+ShaderWatcher::ShaderWatcher()
+{
+}
+
+bool ShaderWatcher::Start(const std::string& newDirectory)
+{
+	directory = newDirectory;
+
+#ifdef _WIN32
+	notification = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (notification == INVALID_HANDLE_VALUE)
+	{
+		notification = nullptr;
+		printf("Shader watcher: can not watch %s\n", directory.c_str());
+		return false;
+	}
+
+	// Notification does not say what changed, so remember what is there now
+	ScanDirectory(false);
+#else
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0)
+	{
+		printf("Shader watcher: inotify not available\n");
+		return false;
+	}
+
+	// Editors either write file in place or write a new one and move it over the old one
+	if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(inotifyFd);
+		inotifyFd = -1;
+		printf("Shader watcher: can not watch %s\n", directory.c_str());
+		return false;
+	}
+#endif
+
+	running = true;
+	thread = std::thread(&ShaderWatcher::Watch, this);
+	return true;
+}
+
+std::vector<std::string> ShaderWatcher::TakeChanges()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::string> taken(changes.begin(), changes.end());
+	changes.clear();
+	return taken;
+}
+
+void ShaderWatcher::Stop()
+{
+	if (!running)
+	{
+		return;
+	}
+
+	running = false;
+	thread.join();
+
+#ifdef _WIN32
+	FindCloseChangeNotification(notification);
+	notification = nullptr;
+	writeTimes.clear();
+#else
+	close(inotifyFd);
+	inotifyFd = -1;
+#endif
+
+	std::lock_guard<std::mutex> lock(mutex);
+	changes.clear();
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+}
+
+#ifdef _WIN32
+void ShaderWatcher::ScanDirectory(bool report)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA((directory + "*").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	do
+	{
+		std::string name = findData.cFileName;
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !isShaderFile(name))
+		{
+			continue;
+		}
+
+		uint64_t writeTime = (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32) | findData.ftLastWriteTime.dwLowDateTime;
+		auto known = writeTimes.find(name);
+		if (known == writeTimes.end() || known->second != writeTime)
+		{
+			writeTimes[name] = writeTime;
+			if (report)
+			{
+				AddChange(name);
+			}
+		}
+	} while (FindNextFileA(find, &findData));
+
+	FindClose(find);
+}
+
+void ShaderWatcher::Watch()
+{
+	while (running)
+	{
+		// Wait with timeout, so stop request is noticed
+		if (WaitForSingleObject(notification, SHADER_WATCH_POLL_MS) != WAIT_OBJECT_0)
+		{
+			continue;
+		}
+
+		ScanDirectory(true);
+		if (!FindNextChangeNotification(notification))
+		{
+			printf("Shader watcher: lost change notification, watching stopped\n");
+			return;
+		}
+	}
+}
+#else
+void ShaderWatcher::Watch()
+{
+	// Aligned for inotify_event, big enough for several events at once
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (running)
+	{
+		// Wait with timeout, so stop request is noticed
+		pollfd pollInfo = {};
+		pollInfo.fd = inotifyFd;
+		pollInfo.events = POLLIN;
+		if (poll(&pollInfo, 1, SHADER_WATCH_POLL_MS) <= 0)
+		{
+			continue;
+		}
+
+		ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+			if (event->len > 0 && isShaderFile(event->name))
+			{
+				AddChange(event->name);
+			}
+			offset += sizeof(struct inotify_event) + event->len;
+		}
+	}
+}
+#endif
+
+void ShaderWatcher::AddChange(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	changes.insert(directory + name);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+// Watches shader directory on a background thread and collects names of shader files written to it
+// (inotify on Linux, change notifications on Windows), so edited shaders can be reloaded while running
+class ShaderWatcher
+{
+public:
+	ShaderWatcher();
+
+	// Start watching directory (not recursive), false if it can not be watched
+	bool Start(const std::string& newDirectory);
+
+	// Files (directory + name) changed since last call, every file once
+	std::vector<std::string> TakeChanges();
+
+	void Stop();
+
+	~ShaderWatcher();
+
+private:
+	std::string directory;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+
+	std::mutex mutex;
+	std::set<std::string> changes;			// Guarded by mutex
+
+#ifdef _WIN32
+	void* notification = nullptr;								// Change notification handle
+	std::map<std::string, uint64_t> writeTimes;					// Last write time of every file, only used by watch thread
+	void ScanDirectory(bool report);
+#else
+	int inotifyFd = -1;
+#endif
+
+	void Watch();
+	void AddChange(const std::string& name);
+};
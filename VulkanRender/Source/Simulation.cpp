@@ -0,0 +1,122 @@
+#include "Simulation.h"
+
+Simulation::Simulation()
+{
+}
+
+void Simulation::SetObjectMaterials(const std::vector<int>& newObjectMaterials)
+{
+	objectMaterials = newObjectMaterials;
+}
+
+void Simulation::Start(FramePacketBuffer* newOutput, double newTickRate)
+{
+	if (running)
+	{
+		return;
+	}
+
+	output = newOutput;
+	tickRate = newTickRate;
+	tick = 0;
+	time = 0.0;
+
+	// Scene (only thing simulated for now is first mesh spinning, once per material, side by side)
+	objects.clear();
+	std::vector<int> materials = objectMaterials.empty() ? std::vector<int>{ -1 } : objectMaterials;
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		SceneObject object;
+		object.meshIndex = 0;
+		object.materialIndex = materials[i];
+		object.position.x = 1.0f * i - 0.5f * (materials.size() - 1);
+		object.spinSpeed = glm::radians(45.0f);
+		objects.push_back(object);
+	}
+
+	// First packet is ready before thread starts, so renderer has something to draw right away
+	WritePacket(output->BeginWrite());
+	output->Publish();
+
+	running = true;
+	thread = std::thread(&Simulation::Run, this);
+}
+
+void Simulation::Stop()
+{
+	running = false;
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+}
+
+bool Simulation::IsRunning()
+{
+	return running;
+}
+
+Simulation::~Simulation()
+{
+	Stop();
+}
+
+void Simulation::Run()
+{
+	auto tickDuration = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+	auto nextTick = std::chrono::high_resolution_clock::now();
+
+	while (running)
+	{
+		Update(1.0 / tickRate);
+
+		// Fill free packet, publishing never waits for render thread
+		WritePacket(output->BeginWrite());
+		output->Publish();
+
+		// Fixed step: sleep until next tick, if we fell behind don't try to catch up with a burst
+		nextTick += tickDuration;
+		auto now = std::chrono::high_resolution_clock::now();
+		if (nextTick < now)
+		{
+			nextTick = now;
+		}
+		std::this_thread::sleep_until(nextTick);
+	}
+}
+
+void Simulation::Update(double deltaTime)
+{
+	tick++;
+	time += deltaTime;
+
+	for (SceneObject& object : objects)
+	{
+		object.angle += object.spinSpeed * (float)deltaTime;
+	}
+}
+
+void Simulation::WritePacket(FramePacket& packet)
+{
+	packet.frameNumber = tick;
+	packet.simulationTime = time;
+
+	packet.camera.position = cameraPosition;
+	packet.camera.view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// Only objects in view distance go to renderer (packet keeps its capacity, so no allocations after first ticks)
+	packet.visibleObjects.clear();
+	for (const SceneObject& object : objects)
+	{
+		if (glm::length(object.position - cameraPosition) - object.radius > viewDistance)
+		{
+			continue;
+		}
+
+		ObjectPacket objectPacket;
+		objectPacket.meshIndex = object.meshIndex;
+		objectPacket.materialIndex = object.materialIndex;
+		objectPacket.transform = glm::rotate(glm::translate(glm::mat4(1.0f), object.position), object.angle, glm::vec3(0.0f, 0.0f, 1.0f));
+		packet.visibleObjects.push_back(objectPacket);
+	}
+}
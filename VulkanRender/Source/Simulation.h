@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "FramePacket.h"
+
+// Update (simulation) work running on its own thread at a fixed tick rate
+// Each tick produces a frame packet for render thread, so simulation and command generation overlap
+class Simulation
+{
+public:
+	Simulation();
+
+	// Renderer material of each scene object, one object is spawned per entry (set before Start, empty = one default object)
+	void SetObjectMaterials(const std::vector<int>& newObjectMaterials);
+
+	void Start(FramePacketBuffer* newOutput, double newTickRate = 120.0);
+	void Stop();
+
+	bool IsRunning();
+
+	~Simulation();
+
+private:
+	// Scene object as simulation sees it (render thread only gets ObjectPacket copies)
+	struct SceneObject
+	{
+		int meshIndex = 0;
+		int materialIndex = -1;
+		glm::vec3 position = glm::vec3(0.0f);
+		float angle = 0.0f;				// Rotation around Z, in radians
+		float spinSpeed = 0.0f;			// Radians per second
+		float radius = 1.0f;			// Bounding sphere for visibility test
+	};
+
+	FramePacketBuffer* output = nullptr;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+
+	double tickRate = 120.0;			// Ticks per second
+	uint64_t tick = 0;
+	double time = 0.0;
+
+	glm::vec3 cameraPosition = glm::vec3(0.0f, 0.0f, 2.0f);
+	float viewDistance = 100.0f;		// Objects further away are not sent to renderer
+	std::vector<SceneObject> objects;
+	std::vector<int> objectMaterials;
+
+	void Run();
+	void Update(double deltaTime);
+	void WritePacket(FramePacket& packet);
+};
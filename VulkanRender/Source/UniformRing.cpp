@@ -0,0 +1,137 @@
+#include "UniformRing.h"
+
+#include <cstdio>
+#include <cstring>
+
+UniformRing::UniformRing()
+{
+}
+
+void UniformRing::Init(VkPhysicalDevice physicalDevice, VkDevice newDevice, VkDescriptorSetLayout newSetLayout, uint32_t binding, VkDeviceSize newDataSize,
+	uint32_t newSliceCount)
+{
+	device = newDevice;
+	setLayout = newSetLayout;
+	dataSize = newDataSize;
+	sliceCount = newSliceCount;
+
+	// Dynamic offsets have to be multiples of device's alignment
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+	VkDeviceSize alignment = deviceProperties.limits.minUniformBufferOffsetAlignment;
+	sliceSize = alignment > 0 ? (dataSize + alignment - 1) / alignment * alignment : dataSize;
+
+	// Coherent memory, written data is visible to GPU without flushing
+	createBuffer(physicalDevice, device, sliceSize * sliceCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, &memory);
+
+	// Mapped for whole lifetime of ring
+	void* data = nullptr;
+	VkResult result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to map Uniform Buffer Memory!");
+	}
+	mapped = static_cast<char*>(data);
+	memset(mapped, 0, static_cast<size_t>(sliceSize * sliceCount));
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	poolSize.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	result = vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &descriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create a Descriptor Pool!");
+	}
+
+	VkDescriptorSetAllocateInfo setAllocateInfo = {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = 1;
+	setAllocateInfo.pSetLayouts = &setLayout;
+
+	result = vkAllocateDescriptorSets(device, &setAllocateInfo, &descriptorSet);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate a Descriptor Set!");
+	}
+
+	// Descriptor sees one slice, dynamic offset moves it along the ring; written once, never again
+	VkDescriptorBufferInfo bufferInfo = {};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = dataSize;
+
+	VkWriteDescriptorSet setWrite = {};
+	setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	setWrite.dstSet = descriptorSet;
+	setWrite.dstBinding = binding;
+	setWrite.descriptorCount = 1;
+	setWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	setWrite.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(device, 1, &setWrite, 0, nullptr);
+
+	printf("Uniform ring: %u slices of %llu bytes (%llu bytes of data)\n", sliceCount, (unsigned long long)sliceSize, (unsigned long long)dataSize);
+}
+
+bool UniformRing::IsActive()
+{
+	return mapped != nullptr;
+}
+
+VkDescriptorSetLayout UniformRing::GetSetLayout()
+{
+	return setLayout;
+}
+
+void UniformRing::Write(uint32_t slice, const void* data, size_t size)
+{
+	memcpy(mapped + slice * sliceSize, data, size < dataSize ? size : static_cast<size_t>(dataSize));
+}
+
+uint32_t UniformRing::GetOffset(uint32_t slice)
+{
+	return static_cast<uint32_t>(slice * sliceSize);
+}
+
+VkDescriptorSet UniformRing::GetDescriptorSet()
+{
+	return descriptorSet;
+}
+
+void UniformRing::Destroy()
+{
+	if (device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	// Descriptor set goes with its pool
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	if (mapped != nullptr)
+	{
+		vkUnmapMemory(device, memory);
+		mapped = nullptr;
+	}
+	vkDestroyBuffer(device, buffer, nullptr);
+	vkFreeMemory(device, memory, nullptr);
+
+	descriptorPool = VK_NULL_HANDLE;
+	descriptorSet = VK_NULL_HANDLE;
+	setLayout = VK_NULL_HANDLE;
+	buffer = VK_NULL_HANDLE;
+	memory = VK_NULL_HANDLE;
+	device = VK_NULL_HANDLE;
+}
+
+UniformRing::~UniformRing()
+{
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "Utilities.h"
+
+// Ring of uniform buffer slices in one persistently mapped buffer, one slice per frame slot
+// A single descriptor set (UNIFORM_BUFFER_DYNAMIC) covers all slices, a dynamic offset picks the slice when binding,
+// so updating uniforms is a memcpy and the descriptor set is never written again
+// Caller makes sure GPU is done with a slice before writing it (frame slot wait)
+class UniformRing
+{
+public:
+	UniformRing();
+
+	// Set layout must have a UNIFORM_BUFFER_DYNAMIC at binding, slices hold dataSize bytes each
+	void Init(VkPhysicalDevice physicalDevice, VkDevice newDevice, VkDescriptorSetLayout newSetLayout, uint32_t binding, VkDeviceSize dataSize,
+		uint32_t newSliceCount);
+
+	bool IsActive();
+
+	// Layout descriptor set was allocated with (a pipeline layout using another one can't bind it)
+	VkDescriptorSetLayout GetSetLayout();
+
+	// Copy data in to slice (size up to dataSize)
+	void Write(uint32_t slice, const void* data, size_t size);
+
+	// Dynamic offset of slice for vkCmdBindDescriptorSets
+	uint32_t GetOffset(uint32_t slice);
+
+	VkDescriptorSet GetDescriptorSet();
+
+	void Destroy();
+
+	~UniformRing();
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;	// Not owned
+
+	char* mapped = nullptr;
+	VkDeviceSize sliceSize = 0;			// Data size rounded up to minUniformBufferOffsetAlignment
+	VkDeviceSize dataSize = 0;
+	uint32_t sliceCount = 0;
+};
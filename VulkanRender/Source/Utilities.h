@@ -1,10 +1,22 @@
 #pragma once
 
 #include <fstream>
+#include <chrono>
 
 #include "glm/glm.hpp"
 
-const int MAX_FRAME_DRAWS = 3;
+const int DEFAULT_FRAME_DRAWS = 3;		// Frames in flight unless changed at runtime
+const int MAX_FRAME_DRAWS = 8;			// Upper limit of frames in flight
+
+const int OFFSCREEN_IMAGE_COUNT = 3;		// Render targets used round robin in headless mode
+const VkFormat OFFSCREEN_IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+const char* const PIPELINE_CACHE_FILE = "pipeline_cache.bin";		// Relative to working directory
+const std::string SHADER_DIRECTORY = "../Shaders/";					// GLSL sources and compiled SPIR-V, relative to working directory
+const std::string SHADER_CACHE_DIRECTORY = "shader_cache/";			// SPIR-V compiled at runtime, relative to working directory
+const uint32_t SCENE_DESCRIPTOR_SET = 0;		// Per-frame scene uniforms, uniform buffers in this set use dynamic offsets
+const uint32_t GRAYSCALE_CONSTANT_ID = 0;		// constant_id of GRAYSCALE (bool) in shader.frag
+const uint64_t PRESENT_WAIT_TIMEOUT = 100000000;	// 100 ms (in ns), hidden window may never present
 
 const std::vector<const char*> deviceExtensions = {
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
@@ -17,11 +29,28 @@ struct Vertex
 	glm::vec3 vertexColor;				// Vertex color (r, g, b)
 };
 
+// Per-frame scene uniforms (set SCENE_DESCRIPTOR_SET, binding 0 in shaders), std140 layout
+struct SceneUniforms
+{
+	glm::mat4 view;						// World to camera
+	glm::mat4 projection;				// Camera to clip space (Vulkan: Y down, depth 0..1)
+	float time;							// Seconds since simulation start
+	float padding[3];
+};
+
+// Per-draw object data, pushed as push constants before each draw (push_constant block in vertex shader)
+struct ObjectPushConstants
+{
+	glm::mat4 model;					// Object to world
+};
+
 // Indieces (locations) of Queue Families (if they exist at all)
 struct QueueFamilyIndices
 {
 	int graphicsFamily = -1;			// Locations of Graphics Queue Family
 	int presentationFamily = -1;		// Location of Presentation Queue Family
+	int transferFamily = -1;			// Location of Transfer Queue Family (transfer only if device has one)
+	int computeFamily = -1;				// Location of Compute Queue Family (compute without graphics if device has one)
 
 	// Check if queue family is valid
 	bool IsValid()
@@ -44,6 +73,39 @@ struct SwapChainDetails
 	}
 };
 
+// CPU/GPU overlap of the frame loop, accumulated over a report interval
+struct FramePacingStats
+{
+	uint32_t frameCount = 0;
+	double frameTimeMs = 0.0;			// CPU time between consecutive Draw calls
+	double frameSlotWaitMs = 0.0;		// CPU time blocked until frame slot was free (GPU behind)
+	double imageWaitMs = 0.0;			// CPU time blocked until swapchain image was free
+	uint64_t queuedFrames = 0;			// Sum of frames queued on GPU at each submit (latency in frames)
+	double presentWaitMs = 0.0;			// CPU time blocked until last frame was presented (low latency loop)
+	uint32_t presentedFrames = 0;		// Frames with measured present latency
+	double presentLatencyMs = 0.0;		// Sum of present latency (frame's vkQueueSubmit call to frame seen on screen)
+	uint32_t fallbackDraws = 0;			// Draws using default pipeline because material was still compiling
+	uint32_t skippedDraws = 0;			// Draws dropped because material was still compiling (no fallback, or fallback not ready either)
+};
+
+// Frame submitted for presentation, waiting for it's latency to be measured
+struct PresentTiming
+{
+	uint64_t presentId = 0;				// VK_KHR_present_id value of frame
+	uint64_t timelineValue = 0;			// Timeline value signalled when GPU finished frame
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;		// Mode frame was presented with
+	std::chrono::high_resolution_clock::time_point submitTime;		// CPU time frame's vkQueueSubmit was called (latency is measured from here)
+};
+
+// Present latency (frame submission to frame on screen) of one presentation mode
+struct PresentLatencyStats
+{
+	uint32_t frameCount = 0;
+	double totalMs = 0.0;
+	double minMs = 0.0;
+	double maxMs = 0.0;
+};
+
 // SwapChain image struct
 struct SwapChainImage
 {
@@ -51,32 +113,66 @@ struct SwapChainImage
 	VkImageView imageView;
 };
 
-static std::vector<char> readFile(const std::string& fileName)
+static uint32_t findMemoryTypeIndex(VkPhysicalDevice physicalDevice, uint32_t allowedTypes, VkMemoryPropertyFlags properties)
 {
-	// open stream from given file
-	// std::ios::binary tells stream to read file as binary
-	// std::ios::ate tells stream to start reading from end of file
-	std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+	// Get properties of physical device memory
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
 
-	printf("Read binary file: %s\n", fileName.c_str());
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		// Index of memory type must match corresponding bit in allowedTypes
+		// and desired property bit flag are part of memory type's property flags
+		if ((allowedTypes & (1 << i))
+			&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			// This memory type is valid, so return it's index
+			return i;
+		}
+	}
+	return 0;
+}
 
-	// Check if file stream successfully open
-	if (!file.is_open())
+static void createBuffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage,
+	VkMemoryPropertyFlags bufferProperties, VkBuffer* buffer, VkDeviceMemory* bufferMemory, uint32_t* memoryTypeIndex = nullptr)
+{
+	// CREATE BUFFER
+	// Information to create a buffer (doesn't include assigning memory)
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = bufferSize;									// Size of buffer
+	bufferInfo.usage = bufferUsage;									// Multiple types of buffer possible
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;				// Similar to Swap Chain images, can share buffer
+
+	VkResult result = vkCreateBuffer(device, &bufferInfo, nullptr, buffer);
+	if (result != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to open a file!");
+		throw std::runtime_error("Failed to create a Buffer!");
 	}
 
-	// Get current read position to resize file buffer
-	size_t fileSize = (size_t)file.tellg();
-	std::vector<char> fileBuffer(fileSize);
+	// Get buffer memory requirements
+	VkMemoryRequirements memRequirements = {};
+	vkGetBufferMemoryRequirements(device, *buffer, &memRequirements);
 
-	// Move read position (seek to) the start of the file
-	file.seekg(0);
+	// Allocate memory to buffer
+	VkMemoryAllocateInfo memAllocInfo = {};
+	memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memAllocInfo.allocationSize = memRequirements.size;
+	memAllocInfo.memoryTypeIndex = findMemoryTypeIndex(physicalDevice, memRequirements.memoryTypeBits, bufferProperties);	// Index of memory type on Physical Device that has required bit flags
 
-	// Read the file data into the buffer (stream "fileSize" in total)
-	file.read(fileBuffer.data(), fileSize);
+	// Allocate memory to VKDeviceMemory
+	result = vkAllocateMemory(device, &memAllocInfo, nullptr, bufferMemory);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate Buffer Memory!");
+	}
 
-	file.close();
+	// Allocate memory to given buffer
+	vkBindBufferMemory(device, *buffer, *bufferMemory, 0);
 
-	return fileBuffer;
-}
\ No newline at end of file
+	// Caller may need to know what memory type was actually picked (e.g. it's coherency)
+	if (memoryTypeIndex != nullptr)
+	{
+		*memoryTypeIndex = memAllocInfo.memoryTypeIndex;
+	}
+}
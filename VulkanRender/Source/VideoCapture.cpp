@@ -0,0 +1,391 @@
+#include "VideoCapture.h"
+
+VideoCapture::VideoCapture()
+{
+}
+
+void VideoCapture::Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkExtent2D newExtent, VkFormat newSourceFormat,
+	const std::string& fileName, int frameRate, VkPipelineCache pipelineCache, ShaderModuleCache* shaderModules,
+	ImmediateSubmitter* newConvertSubmitter, uint32_t newCopyQueueFamily)
+{
+	physicalDevice = newPhysicalDevice;
+	device = newDevice;
+	extent = newExtent;
+	convertSubmitter = newConvertSubmitter;
+	copyQueueFamily = newCopyQueueFamily;
+	lastConvertValue = 0;
+	framesWritten = 0;
+	framesDropped = 0;
+
+	// Shader writes whole words: Y rows padded to 8 pixels, 2 rows per block
+	convertParams.width = extent.width;
+	convertParams.height = extent.height;
+	convertParams.rowLength = (extent.width + 7) & ~7u;
+	convertParams.planeRows = (extent.height + 1) & ~1u;
+	convertParams.bgra = (newSourceFormat == VK_FORMAT_B8G8R8A8_UNORM || newSourceFormat == VK_FORMAT_B8G8R8A8_SRGB) ? 1 : 0;
+
+	file.open(fileName, std::ios::binary);
+	if (!file.is_open())
+	{
+		throw std::runtime_error("Failed to open video capture file!");
+	}
+
+	// C420jpeg: 4:2:0 with chroma centered between luma samples (what 2x2 averaging gives)
+	file << "YUV4MPEG2 W" << extent.width << " H" << extent.height << " F" << frameRate << ":1 Ip A1:1 C420jpeg\n";
+
+	ReadbackLayout yuvLayout;
+	yuvLayout.width = extent.width;
+	yuvLayout.height = extent.height;
+	yuvLayout.format = VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM;
+	yuvLayout.rowLength = convertParams.rowLength;
+	yuvLayout.rowCount = convertParams.planeRows;
+	yuvLayout.size = (VkDeviceSize)convertParams.rowLength * convertParams.planeRows * 3 / 2;
+
+	readback.Init(physicalDevice, device, yuvLayout, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		[this](const ReadbackImage& image)
+		{
+			WriteFrame(image);
+		});
+
+	CreateSourceBuffers();
+	CreatePipeline(pipelineCache, shaderModules);
+	CreateDescriptorSets();
+
+	printf("Video capture: %s (%ux%u, %i fps)\n", fileName.c_str(), extent.width, extent.height, frameRate);
+}
+
+bool VideoCapture::IsActive()
+{
+	return pipeline != VK_NULL_HANDLE;
+}
+
+VkExtent2D VideoCapture::GetExtent()
+{
+	return extent;
+}
+
+int VideoCapture::RecordCopy(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout)
+{
+	int slot = readback.AcquireSlot();
+	if (slot < 0)
+	{
+		framesDropped++;
+		return -1;
+	}
+
+	// Slot is free, so compute queue finished reading its source buffer before this was recorded
+	// Old contents are overwritten, so buffer does not need to be acquired back from compute queue
+	// Image was last written by render pass final transition (or a readback copy's barrier), both made it visible to
+	// transfer stage, so starting at that stage chains this barrier to them
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = imageLayout;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = image;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.bufferOffset = 0;
+	copyRegion.bufferRowLength = 0;
+	copyRegion.bufferImageHeight = 0;
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.mipLevel = 0;
+	copyRegion.imageSubresource.baseArrayLayer = 0;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageOffset = { 0, 0, 0 };
+	copyRegion.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, sourceBuffers[slot], 1, &copyRegion);
+
+	// Image goes back to layout it had, image never leaves this queue
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.dstAccessMask = 0;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = imageLayout;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	// Release half of source buffer's ownership transfer to compute queue family (semaphore covers same family)
+	uint32_t convertQueueFamily = convertSubmitter->GetQueueFamilyIndex();
+	if (copyQueueFamily != convertQueueFamily)
+	{
+		VkBufferMemoryBarrier sourceBarrier = {};
+		sourceBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		sourceBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		sourceBarrier.dstAccessMask = 0;
+		sourceBarrier.srcQueueFamilyIndex = copyQueueFamily;
+		sourceBarrier.dstQueueFamilyIndex = convertQueueFamily;
+		sourceBarrier.buffer = sourceBuffers[slot];
+		sourceBarrier.offset = 0;
+		sourceBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, 1, &sourceBarrier, 0, nullptr);
+	}
+
+	return slot;
+}
+
+void VideoCapture::Convert(int slot, GpuTimeline* copyTimeline, uint64_t copyValue, uint64_t frameNumber)
+{
+	uint32_t srcQueueFamily = copyQueueFamily;
+	uint32_t dstQueueFamily = convertSubmitter->GetQueueFamilyIndex();
+	bool ownershipTransfer = srcQueueFamily != dstQueueFamily;
+	VkBuffer sourceBuffer = sourceBuffers[slot];
+	VkBuffer targetBuffer = readback.GetSlotBuffer(slot);
+	VkDescriptorSet descriptorSet = descriptorSets[slot];
+
+	// Compute queue starts once frame's copy is done, next frame renders meanwhile
+	convertSubmitter->WaitFor(copyTimeline, copyValue, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	SubmitToken token = convertSubmitter->Record(
+		[=](VkCommandBuffer commandBuffer)
+		{
+			// Acquire half of ownership transfer, starts at the stage the semaphore wait blocks
+			if (ownershipTransfer)
+			{
+				VkBufferMemoryBarrier sourceBarrier = {};
+				sourceBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				sourceBarrier.srcAccessMask = 0;
+				sourceBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				sourceBarrier.srcQueueFamilyIndex = srcQueueFamily;
+				sourceBarrier.dstQueueFamilyIndex = dstQueueFamily;
+				sourceBarrier.buffer = sourceBuffer;
+				sourceBarrier.offset = 0;
+				sourceBarrier.size = VK_WHOLE_SIZE;
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+					0, nullptr, 1, &sourceBarrier, 0, nullptr);
+			}
+
+			// Convert, one invocation per 8x2 block
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(YuvConvertParams), &convertParams);
+
+			uint32_t groupCountX = (convertParams.rowLength / 8 + 7) / 8;
+			uint32_t groupCountY = (convertParams.planeRows / 2 + 7) / 8;
+			vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+
+			// YUV planes have to be visible to host once timeline is reached
+			VkBufferMemoryBarrier targetBarrier = {};
+			targetBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			targetBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			targetBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			targetBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			targetBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			targetBarrier.buffer = targetBuffer;
+			targetBarrier.offset = 0;
+			targetBarrier.size = VK_WHOLE_SIZE;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &targetBarrier, 0, nullptr);
+		});
+
+	// Submitted right away, so conversion overlaps next frame instead of waiting for next draw
+	convertSubmitter->Flush();
+	lastConvertValue = convertSubmitter->GetTimelineValue(token);
+	readback.Submitted(slot, lastConvertValue, frameNumber);
+}
+
+void VideoCapture::Collect()
+{
+	readback.Collect(convertSubmitter->GetTimeline());
+}
+
+void VideoCapture::Destroy()
+{
+	if (!IsActive())
+	{
+		return;
+	}
+
+	// Conversions still running on compute queue are written out too, writer thread finishes queued frames first
+	GpuTimeline* convertTimeline = convertSubmitter->GetTimeline();
+	convertTimeline->Wait(lastConvertValue);
+	readback.Collect(convertTimeline);
+	readback.Destroy();
+	file.close();
+	printf("Video capture: %llu frames written, %llu dropped\n", (unsigned long long)framesWritten, (unsigned long long)framesDropped);
+
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	for (size_t i = 0; i < sourceBuffers.size(); i++)
+	{
+		vkDestroyBuffer(device, sourceBuffers[i], nullptr);
+		vkFreeMemory(device, sourceBufferMemories[i], nullptr);
+	}
+	sourceBuffers.clear();
+	sourceBufferMemories.clear();
+
+	pipeline = VK_NULL_HANDLE;
+	descriptorSets.clear();
+}
+
+VideoCapture::~VideoCapture()
+{
+}
+
+void VideoCapture::CreateSourceBuffers()
+{
+	int slotCount = readback.GetSlotCount();
+	sourceBuffers.resize(slotCount);
+	sourceBufferMemories.resize(slotCount);
+	for (int i = 0; i < slotCount; i++)
+	{
+		createBuffer(physicalDevice, device, (VkDeviceSize)extent.width * extent.height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &sourceBuffers[i], &sourceBufferMemories[i]);
+	}
+}
+
+void VideoCapture::CreatePipeline(VkPipelineCache pipelineCache, ShaderModuleCache* shaderModules)
+{
+	// Source buffer and target (readback slot) buffer
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+	for (uint32_t i = 0; i < bindings.size(); i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutCreateInfo.pBindings = bindings.data();
+
+	VkResult result = vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &descriptorSetLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create YUV Descriptor Set Layout!");
+	}
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(YuvConvertParams);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create YUV Pipeline Layout!");
+	}
+
+	// Module stays in cache, so capturing again does not reload it
+	// GLSL source is used directly if it can be compiled at runtime, like graphics shaders
+	std::string shaderFile = ShaderCompiler::IsAvailable() ? "rgb_to_yuv.comp" : "rgb_to_yuv.spv";
+	VkShaderModule shaderModule = shaderModules->Get(SHADER_DIRECTORY + shaderFile);
+
+	VkComputePipelineCreateInfo pipelineCreateInfo = {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineCreateInfo.stage.module = shaderModule;
+	pipelineCreateInfo.stage.pName = "main";
+	pipelineCreateInfo.layout = pipelineLayout;
+
+	result = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create YUV Compute Pipeline!");
+	}
+}
+
+void VideoCapture::CreateDescriptorSets()
+{
+	uint32_t setCount = static_cast<uint32_t>(readback.GetSlotCount());
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = setCount * 2;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = setCount;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	VkResult result = vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &descriptorPool);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create YUV Descriptor Pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts(setCount, descriptorSetLayout);
+
+	VkDescriptorSetAllocateInfo setAllocateInfo = {};
+	setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocateInfo.descriptorPool = descriptorPool;
+	setAllocateInfo.descriptorSetCount = setCount;
+	setAllocateInfo.pSetLayouts = setLayouts.data();
+
+	descriptorSets.resize(setCount);
+	result = vkAllocateDescriptorSets(device, &setAllocateInfo, descriptorSets.data());
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate YUV Descriptor Sets!");
+	}
+
+	for (uint32_t i = 0; i < setCount; i++)
+	{
+		VkDescriptorBufferInfo bufferInfos[2] = {};
+		bufferInfos[0].buffer = sourceBuffers[i];
+		bufferInfos[0].offset = 0;
+		bufferInfos[0].range = VK_WHOLE_SIZE;
+		bufferInfos[1].buffer = readback.GetSlotBuffer(i);
+		bufferInfos[1].offset = 0;
+		bufferInfos[1].range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet setWrite = {};
+		setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		setWrite.dstSet = descriptorSets[i];
+		setWrite.dstBinding = 0;
+		setWrite.dstArrayElement = 0;
+		setWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		setWrite.descriptorCount = 2;						// Fills binding 0 and 1
+		setWrite.pBufferInfo = bufferInfos;
+
+		vkUpdateDescriptorSets(device, 1, &setWrite, 0, nullptr);
+	}
+}
+
+void VideoCapture::WriteFrame(const ReadbackImage& image)
+{
+	// Planes are padded for shader, file gets exact sizes
+	const uint8_t* yPlane = image.pixels;
+	const uint8_t* uPlane = yPlane + (size_t)image.rowLength * image.rowCount;
+	const uint8_t* vPlane = uPlane + (size_t)(image.rowLength / 2) * (image.rowCount / 2);
+	uint32_t chromaWidth = (image.width + 1) / 2;
+	uint32_t chromaHeight = (image.height + 1) / 2;
+
+	file << "FRAME\n";
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		file.write(reinterpret_cast<const char*>(yPlane + (size_t)y * image.rowLength), image.width);
+	}
+	for (uint32_t y = 0; y < chromaHeight; y++)
+	{
+		file.write(reinterpret_cast<const char*>(uPlane + (size_t)y * (image.rowLength / 2)), chromaWidth);
+	}
+	for (uint32_t y = 0; y < chromaHeight; y++)
+	{
+		file.write(reinterpret_cast<const char*>(vPlane + (size_t)y * (image.rowLength / 2)), chromaWidth);
+	}
+
+	framesWritten++;
+}
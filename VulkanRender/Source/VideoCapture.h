@@ -0,0 +1,92 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include "GLFW/glfw3.h"
+
+#include <stdexcept>
+#include <vector>
+#include <array>
+#include <string>
+#include <fstream>
+
+#include "FrameReadback.h"
+#include "GpuTimeline.h"
+#include "ImmediateSubmitter.h"
+#include "ShaderModuleCache.h"
+#include "Utilities.h"
+
+// Push constants of YUV conversion shader (Shaders/rgb_to_yuv.comp)
+struct YuvConvertParams
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t rowLength;
+	uint32_t planeRows;
+	uint32_t bgra;
+};
+
+// Continuous capture of rendered frames to a Y4M (raw YUV 4:2:0) stream
+// Frame is copied to a buffer at end of frame's command buffer, then converted by a compute pass on the compute queue
+// (overlapping next frame's rendering), read back through a buffer ring and written to file by readback worker thread
+class VideoCapture
+{
+public:
+	VideoCapture();
+
+	// Conversion is submitted through convertSubmitter, copies are recorded on copyQueueFamily
+	void Init(VkPhysicalDevice newPhysicalDevice, VkDevice newDevice, VkExtent2D newExtent, VkFormat newSourceFormat,
+		const std::string& fileName, int frameRate, VkPipelineCache pipelineCache, ShaderModuleCache* shaderModules,
+		ImmediateSubmitter* newConvertSubmitter, uint32_t newCopyQueueFamily);
+
+	bool IsActive();
+	VkExtent2D GetExtent();
+
+	// Record copy of image (in given layout, left in that layout) in to source buffer of a free slot, -1 if frame is dropped
+	// Whatever wrote image last has to make it visible to transfer stage (e.g. render pass dependency to VK_SUBPASS_EXTERNAL)
+	int RecordCopy(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout);
+
+	// Copy of slot was submitted and signals copyValue on copyTimeline, submit its conversion on compute queue
+	void Convert(int slot, GpuTimeline* copyTimeline, uint64_t copyValue, uint64_t frameNumber);
+
+	// Hand finished conversions to writer thread (non-blocking)
+	void Collect();
+
+	// Wait for conversions in flight, finish writing and free GPU objects
+	void Destroy();
+
+	~VideoCapture();
+
+private:
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	VkExtent2D extent = {};
+	YuvConvertParams convertParams = {};
+
+	ImmediateSubmitter* convertSubmitter = nullptr;
+	uint32_t copyQueueFamily = 0;
+	uint64_t lastConvertValue = 0;						// Timeline value of latest conversion submitted
+
+	// Source frame copied to device local buffer, shader reads it from there (swapchain images rarely allow storage use)
+	// One per readback slot: slot is only reused once its conversion finished, so copy never waits for compute queue
+	std::vector<VkBuffer> sourceBuffers;
+	std::vector<VkDeviceMemory> sourceBufferMemories;
+
+	// - Pipeline
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> descriptorSets;		// One per readback slot (source and target buffer differ)
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	FrameReadback readback;								// YUV ring and writer thread
+
+	// - Output (only touched by writer thread after Init)
+	std::ofstream file;
+	uint64_t framesWritten = 0;
+	uint64_t framesDropped = 0;
+
+	void CreateSourceBuffers();
+	void CreatePipeline(VkPipelineCache pipelineCache, ShaderModuleCache* shaderModules);
+	void CreateDescriptorSets();
+	void WriteFrame(const ReadbackImage& image);
+};
@@ -1,5 +1,23 @@
 #include "VulkanRenderer.h"
 
+#include "glm/gtc/matrix_transform.hpp"
+
+inline std::string presentModeKHRString(const VkPresentModeKHR presentMode)
+{
+	switch (presentMode)
+	{
+#define STR(r) case VK_PRESENT_MODE_##r##_KHR: return #r
+		STR(IMMEDIATE);
+		STR(MAILBOX);
+		STR(FIFO);
+		STR(FIFO_RELAXED);
+		STR(SHARED_DEMAND_REFRESH);
+		STR(SHARED_CONTINUOUS_REFRESH);
+#undef STR
+	default: return "UNKNOWN_ENUM";
+	}
+}
+
 VulkanRenderer::VulkanRenderer()
 {
 }
@@ -8,13 +26,55 @@ int VulkanRenderer::Init(GLFWwindow* newWindow)
 {
 	window = newWindow;
 
+	// Get notified when window framebuffer changes size, so swapchain can be recreated
+	glfwSetWindowUserPointer(window, this);
+	glfwSetFramebufferSizeCallback(window, FramebufferResizeCallback);
+
+	return InitVulkan();
+}
+
+int VulkanRenderer::InitHeadless(uint32_t width, uint32_t height)
+{
+	headless = true;
+	swapChainExtent = { width, height };
+
+	return InitVulkan();
+}
+
+int VulkanRenderer::InitVulkan()
+{
 	try
 	{
 		CreateInstance();
 		CreateDebugCallback();
-		CreateSurface();
+		if (!headless)
+		{
+			CreateSurface();
+		}
 		GetPhysicalDevice();
+		GetOptionalFeatures();
 		CreateLogicalDevice();
+		CreateSynchronisation();
+		CreateImmediateSubmitters();
+		pipelineCache.Init(mainDevice.physicalDevice, mainDevice.logicalDevice, PIPELINE_CACHE_FILE);
+		pipelineFeedback.Init(optionalFeatures.pipelineCreationFeedback);
+		shaderCompiler.Init(SHADER_CACHE_DIRECTORY);
+		shaderModules.Init(mainDevice.logicalDevice, &shaderCompiler);
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(mainDevice.physicalDevice, &deviceProperties);
+		pipelineLayouts.Init(mainDevice.logicalDevice, &shaderModules, deviceProperties.limits.maxPushConstantsSize);
+		pipelineLayouts.SetDynamicUniformSet(SCENE_DESCRIPTOR_SET);
+		gpuStatistics.Init(mainDevice.logicalDevice, optionalFeatures.pipelineStatistics);
+		gpuStatistics.SetDump(gpuStatisticsDump);
+		pipelineCompiler.Init(pipelineCache.GetCache());
+		// With pipeline library first build is a fast link, optimized link replaces it later
+		pipelineRegistry.Init(mainDevice.logicalDevice, &pipelineCompiler,
+			[this](VkPipelineCache cache, const PipelineDescription& description, PipelineBuildPass pass)
+			{
+				return BuildGraphicsPipeline(cache, description, pass);
+			}, optionalFeatures.graphicsPipelineLibrary);
+		deletionQueue.Init({ &frameTimeline, &transferTimeline, &computeTimeline }, { &transferSubmitter, &computeSubmitter, &immediateSubmitter });
+		shaderWatcher.Start(SHADER_DIRECTORY);
 
 		// Create a mesh
 		std::vector<Vertex> vertices{
@@ -27,16 +87,28 @@ int VulkanRenderer::Init(GLFWwindow* newWindow)
 			{{ 0.4f,-0.4f, 0.0}, { 1.0f, 0.0f, 0.0f}},
 		};
 
-		firstMesh = Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, &vertices);
+		meshList.push_back(Mesh(mainDevice.physicalDevice, mainDevice.logicalDevice, &transferSubmitter, &immediateSubmitter, &vertices));
+
+		// Send all recorded uploads to GPU in one submission per queue, no need to wait for them here
+		transferSubmitter.Flush();
+		immediateSubmitter.Flush();
 
-		CreateSwapChain();
+		if (headless)
+		{
+			CreateOffscreenTargets();
+		}
+		else
+		{
+			CreateSwapChain();
+		}
 		CreateRenderPass();
 		CreateGraphicsPipeline();
+		CreateSceneUniforms();
 		CreateFrameBuffers();
 		CreateCommandPool();
 		CreateCommandBuffers();
-		RecordCommands();
-		CreateSynchronisation();
+
+		imageTimelineValues.assign(swapChainImages.size(), 0);
 	}
 	catch (const std::runtime_error& e)
 	{
@@ -47,34 +119,106 @@ int VulkanRenderer::Init(GLFWwindow* newWindow)
 	return 0;
 }
 
-void VulkanRenderer::Draw()
+void VulkanRenderer::Draw(const FramePacket& packet)
 {
 	// 1. Get next available image to draw to and set something to signal when we're finished with the image (a semaphore)
 	// 2. Submit CommandBuffer to queue for execution, making sure it wait for the image to be signalled as available before drawing
 	// and signals when it has finished rendering
 	// 3. Present image to screen when it has signalled finished rendering
 
+	// Submit one-shot work recorded since last draw, so it overlaps rendering on its own queue
+	// Graphics batch is submitted before the frame, frame may use buffers it acquires from transfer queue
+	transferSubmitter.Flush();
+	computeSubmitter.Flush();
+	immediateSubmitter.Flush();
+
+	// Retire finished one-shot work (frees staging buffers, recycles pools)
+	transferSubmitter.Collect();
+	computeSubmitter.Collect();
+	immediateSubmitter.Collect();
+
+	// Rebuild pipelines of edited shaders, then swap in optimized and rebuilt pipelines that finished, replaced ones go to deletion queue
+	ReloadChangedShaders();
+	RefreshPipelineLayouts(pipelineRegistry.Update(&deletionQueue));
+
+	// Shader modules of edited files go too, once no build can still be creating a pipeline from them
+	if (pipelineCompiler.GetPendingCount() == 0)
+	{
+		shaderModules.ReleaseSuperseded(&deletionQueue);
+	}
+
+	// Destroy objects GPU is done with
+	deletionQueue.Collect();
+
+	// Hand finished frame copies to readback worker
+	frameReadback.Collect(&frameTimeline);
+	videoCapture.Collect();
+
+	// Read pipeline statistics of finished frames
+	gpuStatistics.Collect(&frameTimeline);
+
+	// Measure latency of frames that reached the screen since last draw
+	CollectPresentTimings();
+
 	// -- GET NEXT IMAGE --
 	
-	// Wait for given fence to signal (open) from last draw before continuing
-	vkWaitForFences(mainDevice.logicalDevice, 1, &drawFences[currentFrame], VK_TRUE, std::numeric_limits< uint64_t>::max());
-	// Manualy reset (close) fences
-	vkResetFences(mainDevice.logicalDevice, 1, &drawFences[currentFrame]);
+	// Swapchain could not be rebuilt last time (e.g. window minimised), try again before drawing
+	if (swapChainOutdated && !RecreateSwapChain())
+	{
+		return;
+	}
+
+	// Wait for GPU timeline to reach value signalled by last draw of this frame slot before continuing
+	auto waitStart = std::chrono::high_resolution_clock::now();
+	frameTimeline.Wait(frameTimelineValues[currentFrame]);
+	auto waitEnd = std::chrono::high_resolution_clock::now();
+	framePacing.frameSlotWaitMs += std::chrono::duration<double, std::milli>(waitEnd - waitStart).count();
 
-	// Get index of next image to be draw to, and signal semaphore when ready to be drawn to
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(mainDevice.logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(), imageAvaible[currentFrame], VK_NULL_HANDLE, &imageIndex);
-	if (result != VK_SUCCESS)
+	VkResult result = VK_SUCCESS;
+	if (headless)
 	{
-		throw std::runtime_error("Fuck!");
+		// Offscreen images are used round robin, per image wait below keeps an image from being overwritten too early
+		imageIndex = nextOffscreenImage;
+		nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(swapChainImages.size());
 	}
+	else
+	{
+		// Get index of next image to be draw to, and signal semaphore when ready to be drawn to
+		result = vkAcquireNextImageKHR(mainDevice.logicalDevice, swapChain, std::numeric_limits<uint64_t>::max(), imageAvaible[currentFrame], VK_NULL_HANDLE, &imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// Swapchain no longer matches surface, nothing was acquired (semaphore not signalled), so rebuild and skip frame
+			RecreateSwapChain();
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("Failed to acquire Swapchain Image!");
+		}
+		// VK_SUBOPTIMAL_KHR : image acquired and semaphore will be signalled, so draw this frame and rebuild after present
+	}
+
+	// Image can come back while an older frame (from another frame slot) still renders to it
+	// Its command buffer is also still in use then, so wait for that frame before reusing both
+	waitStart = std::chrono::high_resolution_clock::now();
+	frameTimeline.Wait(imageTimelineValues[imageIndex]);
+	waitEnd = std::chrono::high_resolution_clock::now();
+	framePacing.imageWaitMs += std::chrono::duration<double, std::milli>(waitEnd - waitStart).count();
 	//printf("imageIndex = %u \n", imageIndex);
 
+	// -- RECORD COMMANDS --
+	// Frame slot's uniform slice is free again too (GPU finished last frame of slot)
+	UpdateSceneUniforms(packet);
+
+	// Command buffer of image is free again, record it from this frame's packet
+	RecordCommands(imageIndex, packet);
+
 	// -- SUBMIT COMMAND BUFFER TO RENDER --
 	// Queue submission information
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.waitSemaphoreCount = 1;								// Number of semaphores to wait on
+	submitInfo.waitSemaphoreCount = headless ? 0 : 1;				// Number of semaphores to wait on (nothing acquired in headless mode)
 	submitInfo.pWaitSemaphores = &imageAvaible[currentFrame];		// List of semaphores to wait on
 	VkPipelineStageFlags waitStages[] = {
 		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
@@ -82,15 +226,63 @@ void VulkanRenderer::Draw()
 	submitInfo.pWaitDstStageMask = waitStages;						// Stages to check semaphores at
 	submitInfo.commandBufferCount = 1;								// Number of command buffer submited
 	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];		// Command Buffer to sumbit
-	submitInfo.signalSemaphoreCount = 1;							// Number of semaphores to signal
-	submitInfo.pSignalSemaphores = &renderFinished[currentFrame];	// Semaphores to signal when command buffer finishes
+	VkSemaphore signalSemaphores[] = {
+		renderFinished[currentFrame],								// Binary semaphore for presentation engine
+		frameTimeline.GetSemaphore()								// Timeline semaphore for frame retirement
+	};
+	submitInfo.signalSemaphoreCount = 2;							// Number of semaphores to signal
+	submitInfo.pSignalSemaphores = signalSemaphores;				// Semaphores to signal when command buffer finishes
+	if (headless)
+	{
+		// Nothing presents, so only timeline is signalled (a binary semaphore nobody waits on can't be signalled again)
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &signalSemaphores[1];
+	}
+
+	// Values for timeline semaphores (binary semaphores ignore theirs)
+	uint64_t frameValue = frameTimeline.NextValue();
+	uint64_t waitValues[] = { 0 };
+	uint64_t signalValues[] = { 0, frameValue };
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = 1;
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+	timelineSubmitInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+	timelineSubmitInfo.pSignalSemaphoreValues = headless ? &signalValues[1] : signalValues;
+	submitInfo.pNext = &timelineSubmitInfo;
 	
-	// Submit command buffer to queue
-	result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, drawFences[currentFrame]);
+	// Submit command buffer to queue (no fence, frame is retired by timeline value)
+	// Present latency is measured on CPU from this call, GPU work of frame and presentation both count
+	auto submitTime = std::chrono::high_resolution_clock::now();
+	result = vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to submit Command Buffer to Queue!");
 	}
+	frameTimelineValues[currentFrame] = frameValue;
+	imageTimelineValues[imageIndex] = frameValue;
+
+	if (recordedReadbackSlot >= 0)
+	{
+		frameReadback.Submitted(recordedReadbackSlot, frameValue, frameCount);
+	}
+	gpuStatistics.Submitted(recordedStatisticsSlot, frameValue, frameCount);
+	if (recordedCaptureSlot >= 0)
+	{
+		videoCapture.Convert(recordedCaptureSlot, &frameTimeline, frameValue, frameCount);
+	}
+	frameCount++;
+
+	// Frames GPU still has to finish (including this one)
+	framePacing.queuedFrames += frameValue - frameTimeline.GetCompletedValue();
+
+	// Headless frame is done once submitted, loop is paced by timeline waits alone
+	if (headless)
+	{
+		currentFrame = (currentFrame + 1) % framesInFlight;
+		ReportFramePacing();
+		return;
+	}
 
 	// -- PRESENT RENDERED IMAGE TO SCREEN --
 	VkPresentInfoKHR presentInfo = {};
@@ -101,43 +293,334 @@ void VulkanRenderer::Draw()
 	presentInfo.pSwapchains = &swapChain;						// Swapchains to present images to
 	presentInfo.pImageIndices = &imageIndex;					// Index of images in swapchains to present
 
+	// Tag frame with an id, so CPU can wait until exactly this frame is on screen
+	uint64_t presentId = lastPresentId + 1;
+	VkPresentIdKHR presentIdInfo = {};
+	presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+	presentIdInfo.swapchainCount = 1;
+	presentIdInfo.pPresentIds = &presentId;
+	if (optionalFeatures.presentWait)
+	{
+		presentInfo.pNext = &presentIdInfo;
+	}
+
 	result = vkQueuePresentKHR(presentationQueue, &presentInfo);
-	if (result != VK_SUCCESS)
+
+	// Out of date swapchain did not present image, everything else queued it
+	if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+	{
+		lastPresentId = presentId;
+
+		PresentTiming timing;
+		timing.presentId = presentId;
+		timing.timelineValue = frameValue;
+		timing.presentMode = presentMode;
+		timing.submitTime = submitTime;
+		pendingPresents.push_back(timing);
+
+		// Nobody collects while window is hidden, don't grow forever
+		if (pendingPresents.size() > static_cast<size_t>(2 * MAX_FRAME_DRAWS))
+		{
+			pendingPresents.pop_front();
+		}
+	}
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
+	{
+		framebufferResized = false;
+		RecreateSwapChain();
+	}
+	else if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to present Image!");
 	}
 
-	// Get next frame (use % MAX_FRAME_DRAWS to keep value below MAX_FRAME_DRAWS)
-	currentFrame = (currentFrame + 1) % MAX_FRAME_DRAWS;
+	// Get next frame (use % framesInFlight to keep value below framesInFlight)
+	currentFrame = (currentFrame + 1) % framesInFlight;
+
+	ReportFramePacing();
+}
+
+void VulkanRenderer::WaitForFrames()
+{
+	frameTimeline.Wait(frameTimeline.GetLastSignalValue());
+}
+
+bool VulkanRenderer::SetReadback(const ReadbackCallback& callback, int frameInterval)
+{
+	// Submitted frames may still copy to current ring, let them finish and hand them over first
+	frameTimeline.Wait(frameTimeline.GetLastSignalValue());
+	frameReadback.Collect(&frameTimeline);
+	frameReadback.Destroy();
+
+	readbackCallback = callback;
+	readbackInterval = std::max(1, frameInterval);
+	if (!readbackCallback)
+	{
+		return true;
+	}
+
+	if (!swapChainTransferSrc)
+	{
+		printf("Swapchain images can't be copied from, readback disabled\n");
+		return false;
+	}
+
+	frameReadback.Init(mainDevice.physicalDevice, mainDevice.logicalDevice, swapChainExtent, swapChainImageFormat, readbackCallback);
+	return true;
+}
+
+bool VulkanRenderer::StartVideoCapture(const std::string& fileName, int frameRate)
+{
+	StopVideoCapture();
+
+	if (!swapChainTransferSrc)
+	{
+		printf("Swapchain images can't be copied from, video capture disabled\n");
+		return false;
+	}
+
+	// Frame is copied on graphics queue, converted on compute queue
+	QueueFamilyIndices indices = GetQueueFamilies(mainDevice.physicalDevice);
+	videoCapture.Init(mainDevice.physicalDevice, mainDevice.logicalDevice, swapChainExtent, swapChainImageFormat, fileName, std::max(1, frameRate),
+		pipelineCache.GetCache(), &shaderModules, &computeSubmitter, indices.graphicsFamily);
+	return true;
+}
+
+void VulkanRenderer::StopVideoCapture()
+{
+	// Submitted frames may still convert in to capture ring, they are written out before closing file
+	videoCapture.Destroy();
+}
+
+void VulkanRenderer::UnloadMesh(int meshIndex)
+{
+	if (meshIndex < 0 || meshIndex >= (int)meshList.size())
+	{
+		return;
+	}
+
+	// No waiting here, packets drawn from now on skip the empty mesh
+	meshList[meshIndex].DestroyVertexBuffer(&deletionQueue);
+}
+
+int VulkanRenderer::AddMaterial(const std::string& vertexShaderFile, const std::string& fragmentShaderFile, bool useFallback)
+{
+	// Materials with same state as an existing one get it's pipeline, no second compile
+	Material material;
+	material.description = MakePipelineDescription(vertexShaderFile, fragmentShaderFile);
+	material.useFallback = useFallback;
+	material.pipeline = pipelineRegistry.Get(material.description);
+	materials.push_back(material);
+
+	return static_cast<int>(materials.size()) - 1;
+}
+
+int VulkanRenderer::AddMaterialVariant(int materialIndex, const std::vector<ShaderConstant>& constants)
+{
+	if (materialIndex < 0 || materialIndex >= (int)materials.size())
+	{
+		throw std::runtime_error("Failed to add a Material variant, base material does not exist!");
+	}
+
+	// Same state and shaders, only constants differ; variant with same values as an existing one shares it's pipeline
+	Material material = materials[materialIndex];
+	for (const ShaderConstant& constant : constants)
+	{
+		material.description.SetSpecializationConstant(constant);
+	}
+	material.pipeline = pipelineRegistry.Get(material.description);
+	materials.push_back(material);
+
+	return static_cast<int>(materials.size()) - 1;
+}
+
+void VulkanRenderer::GetDefaultShaderFiles(std::string& vertexShaderFile, std::string& fragmentShaderFile)
+{
+	// GLSL sources are used directly if they can be compiled at runtime
+	if (ShaderCompiler::IsAvailable())
+	{
+		vertexShaderFile = SHADER_DIRECTORY + "shader.vert";
+		fragmentShaderFile = SHADER_DIRECTORY + "shader.frag";
+	}
+	else
+	{
+		vertexShaderFile = SHADER_DIRECTORY + "vert.spv";
+		fragmentShaderFile = SHADER_DIRECTORY + "frag.spv";
+	}
+}
+
+void VulkanRenderer::SetFramesInFlight(int count)
+{
+	count = std::max(1, std::min(MAX_FRAME_DRAWS, count));
+	if (count == framesInFlight)
+	{
+		return;
+	}
+
+	// Frame slot semaphores may still be used by submitted frames
+	frameTimeline.Wait(frameTimeline.GetLastSignalValue());
+
+	DestroyFrameSlots();
+	framesInFlight = count;
+	CreateFrameSlots();
+
+	printf("Frames in flight: %i\n", framesInFlight);
+}
+
+int VulkanRenderer::GetFramesInFlight()
+{
+	return framesInFlight;
+}
+
+FramePacingStats VulkanRenderer::GetFramePacingStats()
+{
+	return lastFramePacing;
+}
+
+GpuFrameStatistics VulkanRenderer::GetGpuStatistics()
+{
+	return gpuStatistics.GetLastFrame();
+}
+
+void VulkanRenderer::SetGpuStatisticsDump(bool enable)
+{
+	gpuStatisticsDump = enable;
+	gpuStatistics.SetDump(enable);
+}
+
+bool VulkanRenderer::GetGpuStatisticsDump()
+{
+	return gpuStatisticsDump;
+}
+
+void VulkanRenderer::SetShaderOptimization(bool enable)
+{
+	shaderCompiler.SetOptimization(enable);
+}
+
+ShaderCompilerStats VulkanRenderer::GetShaderCompilerStats()
+{
+	return shaderCompiler.GetStats();
+}
+
+PipelineCreationStats VulkanRenderer::GetPipelineCreationStats()
+{
+	return pipelineFeedback.GetStats();
+}
+
+bool VulkanRenderer::SetPresentMode(VkPresentModeKHR mode)
+{
+	// Nothing is presented without a surface
+	if (headless)
+	{
+		return false;
+	}
+
+	SwapChainDetails swapChainDetails = GetSwapChainDetails(mainDevice.physicalDevice);
+	if (std::find(swapChainDetails.presentationModes.begin(), swapChainDetails.presentationModes.end(), mode) == swapChainDetails.presentationModes.end())
+	{
+		printf("Presentation mode %s not supported by surface\n", presentModeKHRString(mode).c_str());
+		return false;
+	}
+
+	requestedPresentMode = mode;
+
+	// Swapchain is rebuilt at start of next draw, outside of any frame
+	if (mode != presentMode)
+	{
+		swapChainOutdated = true;
+	}
+
+	return true;
+}
+
+VkPresentModeKHR VulkanRenderer::GetPresentMode()
+{
+	return presentMode;
+}
+
+PresentLatencyStats VulkanRenderer::GetPresentLatencyStats(VkPresentModeKHR mode)
+{
+	return presentLatency[mode];
+}
+
+void VulkanRenderer::WaitForPresent()
+{
+	if (pendingPresents.empty())
+	{
+		return;
+	}
+
+	// Wait for newest frame, older ones are on screen (or replaced) once it is
+	auto waitStart = std::chrono::high_resolution_clock::now();
+	IsPresented(pendingPresents.back(), PRESENT_WAIT_TIMEOUT);
+	auto waitEnd = std::chrono::high_resolution_clock::now();
+	framePacing.presentWaitMs += std::chrono::duration<double, std::milli>(waitEnd - waitStart).count();
+
+	CollectPresentTimings();
 }
 
 void VulkanRenderer::Cleanup()
 {
 	// Wait until no actions being run on device before destroying
 	vkDeviceWaitIdle(mainDevice.logicalDevice);
-
-	firstMesh.DestroyVertexBuffer();
-
-	for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
+	shaderWatcher.Stop();
+
+	ReportPresentLatency();
+	ReportShaderCompilation();
+
+	// Finish frames still in readback ring
+	frameReadback.Collect(&frameTimeline);
+	frameReadback.Destroy();
+	videoCapture.Destroy();
+	gpuStatistics.Collect(&frameTimeline);
+	gpuStatistics.Destroy();
+
+	immediateSubmitter.Destroy();
+	transferSubmitter.Destroy();
+	computeSubmitter.Destroy();
+	for (Mesh& mesh : meshList)
 	{
-		vkDestroySemaphore(mainDevice.logicalDevice, imageAvaible[i], nullptr);
-		vkDestroySemaphore(mainDevice.logicalDevice, renderFinished[i], nullptr);
-		vkDestroyFence(mainDevice.logicalDevice, drawFences[i], nullptr);
+		mesh.DestroyVertexBuffer();
 	}
+	deletionQueue.Flush();
+
+	DestroyFrameSlots();
+	sceneUniforms.Destroy();
+	frameTimeline.Destroy();
+	transferTimeline.Destroy();
+	computeTimeline.Destroy();
 	vkDestroyCommandPool(mainDevice.logicalDevice, graphicsCommandPool, nullptr);
 	for (VkFramebuffer& frameBuffer : swapChainFrameBuffers)
 	{
 		vkDestroyFramebuffer(mainDevice.logicalDevice, frameBuffer, nullptr);
 	}
-	vkDestroyPipeline(mainDevice.logicalDevice, graphicsPipeline, nullptr);
-	vkDestroyPipelineLayout(mainDevice.logicalDevice, pipelineLayout, nullptr);
+	pipelineCompiler.Destroy();
+	pipelineRegistry.Destroy();
+	pipelineLibrary.Destroy();
+	pipelineLayouts.Destroy();
+	shaderModules.Destroy();
+	shaderCompiler.Destroy();
+	pipelineCache.Save();
+	pipelineCache.Destroy();
 	vkDestroyRenderPass(mainDevice.logicalDevice, renderPass, nullptr);
 	for (SwapChainImage& image : swapChainImages)
 	{
 		vkDestroyImageView(mainDevice.logicalDevice, image.imageView, nullptr);
 	}
-	vkDestroySwapchainKHR(mainDevice.logicalDevice, swapChain, nullptr);
-	vkDestroySurfaceKHR(instance, surface, nullptr);
+	if (headless)
+	{
+		for (size_t i = 0; i < swapChainImages.size(); i++)
+		{
+			vkDestroyImage(mainDevice.logicalDevice, swapChainImages[i].image, nullptr);
+			vkFreeMemory(mainDevice.logicalDevice, offscreenImageMemory[i], nullptr);
+		}
+	}
+	else
+	{
+		vkDestroySwapchainKHR(mainDevice.logicalDevice, swapChain, nullptr);
+		vkDestroySurfaceKHR(instance, surface, nullptr);
+	}
 	vkDestroyDevice(mainDevice.logicalDevice, nullptr);
 	if (validationEnabled)
 	{
@@ -171,7 +654,7 @@ void VulkanRenderer::CreateInstance()
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);			// Custom version of application
 	appInfo.pEngineName = "No Engine";								// Custom engine name
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);				// Custom engine version
-	appInfo.apiVersion = VK_API_VERSION_1_0;						// The Vulkan vertion
+	appInfo.apiVersion = VK_API_VERSION_1_2;						// The Vulkan vertion (1.2 for timeline semaphores)
 
 	// Creation information for VKInstance (Vulkan Instance)
 	VkInstanceCreateInfo createInfo = {};
@@ -185,8 +668,8 @@ void VulkanRenderer::CreateInstance()
 	uint32_t glfwExtensionCount = 0;	// GLFW may require multiplr extensions
 	const char **glfwExtensions;		// Extensions passed as array of cstrings, so need pointer (the array) to pointer (char)
 
-	// Get GLFW extensions
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	// Get GLFW extensions (surface extensions, not needed without a window)
+	glfwExtensions = headless ? nullptr : glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 	printf("Vulkan extensions count: %u\n", glfwExtensionCount);
 
 	// Add GLFW extensions to list of extensions
@@ -263,16 +746,45 @@ void VulkanRenderer::CreateLogicalDevice()
 
 	// Vector for queue creation information, and set for family indices
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<int> queueFamilyIndices = {indices.graphicsFamily, indices.presentationFamily};
+	std::set<int> queueFamilyIndices = {indices.graphicsFamily, indices.presentationFamily, indices.transferFamily, indices.computeFamily};
 
-	// Queues the logical device needs to create and info to do so (Only 1 for now, will add more later!)
+	// Required extensions plus optional ones device supports (swapchain is not required in headless mode)
+	enabledDeviceExtensions = headless ? std::vector<const char*>() : deviceExtensions;
+	if (optionalFeatures.presentWait)
+	{
+		enabledDeviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+		enabledDeviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	}
+	if (optionalFeatures.extendedDynamicState)
+	{
+		enabledDeviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+	}
+	if (optionalFeatures.extendedDynamicState2)
+	{
+		enabledDeviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+	}
+	if (optionalFeatures.dynamicPolygonMode || optionalFeatures.dynamicBlend)
+	{
+		enabledDeviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+	}
+	if (optionalFeatures.graphicsPipelineLibrary)
+	{
+		enabledDeviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+		enabledDeviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+	}
+	if (optionalFeatures.pipelineCreationFeedback)
+	{
+		enabledDeviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+	}
+
+	// Queues the logical device needs to create and info to do so (1 queue of each family used)
+	float priority = 1.0f;													// Has to stay alive until device is created
 	for (int queueFamilyIndex : queueFamilyIndices)
 	{
 		VkDeviceQueueCreateInfo queueCreateInfo = {};
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queueCreateInfo.queueFamilyIndex = queueFamilyIndex;				// The index of the family to create a queue from
 		queueCreateInfo.queueCount = 1;										// Number of queues to create
-		float priority = 1.0f;
 		queueCreateInfo.pQueuePriorities = &priority;						// Vulkan need to know how to handle multiple queues, so decide priority (1 = highest priority)
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
@@ -282,13 +794,79 @@ void VulkanRenderer::CreateLogicalDevice()
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());		// Number of Queue Create Infos
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();								// List of queue infos so device can create required queues
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());	// Number of enabled logical device extensions
-	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();							// List of enabled logical device extensions
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions.size());	// Number of enabled logical device extensions
+	deviceCreateInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();							// List of enabled logical device extensions
 	
 	// Physical Device Features the Logical Device will be using
 	VkPhysicalDeviceFeatures deviceFeatures = {};
+	deviceFeatures.pipelineStatisticsQuery = optionalFeatures.pipelineStatistics ? VK_TRUE : VK_FALSE;	// Vertex/clipping/fragment work per pass
 
 	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;	// Physical Device features Logical Device will use
+
+	// Vulkan 1.2 features, chained to device create info
+	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12Features.timelineSemaphore = VK_TRUE;			// One GPU timeline for frame pacing and one-shot work
+
+	deviceCreateInfo.pNext = &vulkan12Features;
+
+	// Present id/wait features, chained after Vulkan 1.2 features if enabled
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+	presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	presentIdFeatures.presentId = VK_TRUE;
+
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+	presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	presentWaitFeatures.pNext = &presentIdFeatures;
+	presentWaitFeatures.presentWait = VK_TRUE;
+
+	// Extended dynamic state features, only the parts renderer uses
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicStateFeatures = {};
+	dynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+	dynamicStateFeatures.extendedDynamicState = VK_TRUE;
+
+	VkPhysicalDeviceExtendedDynamicState2FeaturesEXT dynamicState2Features = {};
+	dynamicState2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+	dynamicState2Features.extendedDynamicState2 = VK_TRUE;
+
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features = {};
+	dynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+	dynamicState3Features.extendedDynamicState3PolygonMode = optionalFeatures.dynamicPolygonMode ? VK_TRUE : VK_FALSE;
+	dynamicState3Features.extendedDynamicState3ColorBlendEnable = optionalFeatures.dynamicBlend ? VK_TRUE : VK_FALSE;
+	dynamicState3Features.extendedDynamicState3ColorBlendEquation = optionalFeatures.dynamicBlend ? VK_TRUE : VK_FALSE;
+	dynamicState3Features.extendedDynamicState3ColorWriteMask = optionalFeatures.dynamicBlend ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures = {};
+	pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+	pipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+
+	// Chain enabled feature structs after Vulkan 1.2 features
+	void** chainEnd = &vulkan12Features.pNext;
+	if (optionalFeatures.presentWait)
+	{
+		*chainEnd = &presentWaitFeatures;
+		chainEnd = &presentIdFeatures.pNext;
+	}
+	if (optionalFeatures.extendedDynamicState)
+	{
+		*chainEnd = &dynamicStateFeatures;
+		chainEnd = &dynamicStateFeatures.pNext;
+	}
+	if (optionalFeatures.extendedDynamicState2)
+	{
+		*chainEnd = &dynamicState2Features;
+		chainEnd = &dynamicState2Features.pNext;
+	}
+	if (optionalFeatures.dynamicPolygonMode || optionalFeatures.dynamicBlend)
+	{
+		*chainEnd = &dynamicState3Features;
+		chainEnd = &dynamicState3Features.pNext;
+	}
+	if (optionalFeatures.graphicsPipelineLibrary)
+	{
+		*chainEnd = &pipelineLibraryFeatures;
+		chainEnd = &pipelineLibraryFeatures.pNext;
+	}
 	
 	// Create the logival device for the given physical device
 	VkResult result = vkCreateDevice(mainDevice.physicalDevice, &deviceCreateInfo, nullptr, &mainDevice.logicalDevice);
@@ -302,10 +880,62 @@ void VulkanRenderer::CreateLogicalDevice()
 	// From given logical device, of given Queue Index (0 since only one queue), place reference in given vkQueue
 	vkGetDeviceQueue(mainDevice.logicalDevice, indices.graphicsFamily, 0, &graphicsQueue);
 	vkGetDeviceQueue(mainDevice.logicalDevice, indices.presentationFamily, 0, &presentationQueue);
+	vkGetDeviceQueue(mainDevice.logicalDevice, indices.transferFamily, 0, &transferQueue);
+	vkGetDeviceQueue(mainDevice.logicalDevice, indices.computeFamily, 0, &computeQueue);
+	printf("Queue families: graphics %i, presentation %i, transfer %i, compute %i\n",
+		indices.graphicsFamily, indices.presentationFamily, indices.transferFamily, indices.computeFamily);
+
+	// Extension functions are not exported by loader, get them from device
+	if (optionalFeatures.presentWait)
+	{
+		fpWaitForPresentKHR = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkWaitForPresentKHR");
+		optionalFeatures.presentWait = fpWaitForPresentKHR != nullptr;
+	}
+	if (optionalFeatures.extendedDynamicState)
+	{
+		dynamicStateFunctions.setCullMode = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetCullModeEXT");
+		dynamicStateFunctions.setFrontFace = (PFN_vkCmdSetFrontFaceEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetFrontFaceEXT");
+		dynamicStateFunctions.setPrimitiveTopology = (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetPrimitiveTopologyEXT");
+		optionalFeatures.extendedDynamicState = dynamicStateFunctions.setCullMode != nullptr && dynamicStateFunctions.setFrontFace != nullptr
+			&& dynamicStateFunctions.setPrimitiveTopology != nullptr;
+	}
+	if (optionalFeatures.extendedDynamicState2)
+	{
+		dynamicStateFunctions.setPrimitiveRestartEnable = (PFN_vkCmdSetPrimitiveRestartEnableEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetPrimitiveRestartEnableEXT");
+		optionalFeatures.extendedDynamicState2 = dynamicStateFunctions.setPrimitiveRestartEnable != nullptr;
+	}
+	if (optionalFeatures.dynamicPolygonMode)
+	{
+		dynamicStateFunctions.setPolygonMode = (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetPolygonModeEXT");
+		optionalFeatures.dynamicPolygonMode = dynamicStateFunctions.setPolygonMode != nullptr;
+	}
+	if (optionalFeatures.dynamicBlend)
+	{
+		dynamicStateFunctions.setColorBlendEnable = (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetColorBlendEnableEXT");
+		dynamicStateFunctions.setColorBlendEquation = (PFN_vkCmdSetColorBlendEquationEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetColorBlendEquationEXT");
+		dynamicStateFunctions.setColorWriteMask = (PFN_vkCmdSetColorWriteMaskEXT)vkGetDeviceProcAddr(mainDevice.logicalDevice, "vkCmdSetColorWriteMaskEXT");
+		optionalFeatures.dynamicBlend = dynamicStateFunctions.setColorBlendEnable != nullptr && dynamicStateFunctions.setColorBlendEquation != nullptr
+			&& dynamicStateFunctions.setColorWriteMask != nullptr;
+	}
 	printf("Logical Device successful connect to Physical Device\n");
 	printf("----------------------------------\n");
 }
 
+void VulkanRenderer::CreateImmediateSubmitters()
+{
+	QueueFamilyIndices indices = GetQueueFamilies(mainDevice.physicalDevice);
+
+	// Graphics work shares frame timeline, so later frames on the same queue are ordered after it
+	immediateSubmitter.Init(mainDevice.logicalDevice, graphicsQueue, indices.graphicsFamily, &frameTimeline);
+
+	// Each queue signals its own timeline (values on one timeline must increase in submission order)
+	transferTimeline.Init(mainDevice.logicalDevice);
+	transferSubmitter.Init(mainDevice.logicalDevice, transferQueue, indices.transferFamily, &transferTimeline);
+
+	computeTimeline.Init(mainDevice.logicalDevice);
+	computeSubmitter.Init(mainDevice.logicalDevice, computeQueue, indices.computeFamily, &computeTimeline);
+}
+
 void VulkanRenderer::CreateSurface()
 {
 	// Create Surface (creates a surface create info struct, runs the create surface function, returns result)
@@ -316,22 +946,6 @@ void VulkanRenderer::CreateSurface()
 	}
 }
 
-inline std::string presentModeKHRString(const VkPresentModeKHR presentMode)
-{
-	switch (presentMode)
-	{
-#define STR(r) case VK_PRESENT_MODE_##r##_KHR: return #r
-		STR(IMMEDIATE);
-		STR(MAILBOX);
-		STR(FIFO);
-		STR(FIFO_RELAXED);
-		STR(SHARED_DEMAND_REFRESH);
-		STR(SHARED_CONTINUOUS_REFRESH);
-#undef STR
-	default: return "UNKNOWN_ENUM";
-	}
-}
-
 inline std::string formatString(const VkFormat format)
 {
 	switch (format)
@@ -610,7 +1224,7 @@ void VulkanRenderer::CreateSwapChain()
 	printf("Surface color space: %s\n", colorSpaceKHRString(surfaceFormat.colorSpace).c_str());
 
 	// Choose best presentation format
-	VkPresentModeKHR presentMode = ChooseBestPresentationMode(swapChainDetails.presentationModes);
+	presentMode = ChooseBestPresentationMode(swapChainDetails.presentationModes);
 	printf("Surface presentaion mode: %s\n", presentModeKHRString(presentMode).c_str());
 
 	// Choose Swap Chain image resolution
@@ -641,6 +1255,13 @@ void VulkanRenderer::CreateSwapChain()
 	swapChainCreateInfo.minImageCount = imageCount;								// Swapchain image count
 	swapChainCreateInfo.imageArrayLayers = 1;									// Number of layer for each image in chain
 	swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;		// What attachment images will be used as
+
+	// Also copy source if surface allows, so frames can be read back
+	swapChainTransferSrc = (swapChainDetails.surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+	if (swapChainTransferSrc)
+	{
+		swapChainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
 	swapChainCreateInfo.preTransform = swapChainDetails.surfaceCapabilities.currentTransform; // Transform to perform on swap chain
 	swapChainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;						// How to handle blending images with external graphics (e. g. other windows)
 	swapChainCreateInfo.clipped = VK_TRUE;														// Whether to clip parts of image not in view (e.g. behind another window, off screen, etc)
@@ -667,7 +1288,8 @@ void VulkanRenderer::CreateSwapChain()
 		swapChainCreateInfo.pQueueFamilyIndices = nullptr;
 	}
 	// If old swapchain been destroyed and this one replaces it, then link old one to quikly hand over responsibilities
-	swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+	VkSwapchainKHR oldSwapChain = swapChain;
+	swapChainCreateInfo.oldSwapchain = oldSwapChain;
 
 	// Create Swapchain
 
@@ -676,17 +1298,29 @@ void VulkanRenderer::CreateSwapChain()
 	{
 		throw std::runtime_error("Failed to create Swapchain!");
 	}
+
+	// Old swapchain is retired by now, it's images views were destroyed before recreation
+	// Presents queued on it may still be pending (frame timeline only covers rendering), so present queue is idled first
+	if (oldSwapChain != VK_NULL_HANDLE)
+	{
+		vkQueueWaitIdle(presentationQueue);
+		vkDestroySwapchainKHR(mainDevice.logicalDevice, oldSwapChain, nullptr);
+	}
 	
 	// Store for later reference
 	swapChainImageFormat = surfaceFormat.format;
 	swapChainExtent = extent;
 
+	// Present ids are waited on per swapchain, older ones belong to the retired swapchain
+	swapChainFirstPresentId = lastPresentId + 1;
+
 	// Get Swapchain images (first count, then values)
 	uint32_t swapchainImageCount;
 	vkGetSwapchainImagesKHR(mainDevice.logicalDevice, swapChain, &swapchainImageCount, nullptr);
 	std::vector<VkImage> images(swapchainImageCount);
 	vkGetSwapchainImagesKHR(mainDevice.logicalDevice, swapChain, &swapchainImageCount, images.data());
 
+	swapChainImages.clear();
 	for (VkImage image : images)
 	{
 		// Store image hangle
@@ -702,6 +1336,146 @@ void VulkanRenderer::CreateSwapChain()
 	printf("----------------------------------\n");
 }
 
+void VulkanRenderer::CreateOffscreenTargets()
+{
+	printf("STAGE: Create Offscreen Targets\n\n");
+
+	// Plain images take the place of swapchain images, extent was set by InitHeadless
+	swapChainImageFormat = OFFSCREEN_IMAGE_FORMAT;
+	swapChainTransferSrc = true;
+
+	for (int i = 0; i < OFFSCREEN_IMAGE_COUNT; i++)
+	{
+		VkImageCreateInfo imageCreateInfo = {};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;							// Type of image (1D, 2D or 3D)
+		imageCreateInfo.extent.width = swapChainExtent.width;					// Width of image extent
+		imageCreateInfo.extent.height = swapChainExtent.height;					// Height of image extent
+		imageCreateInfo.extent.depth = 1;										// Depth of image (just 1, no 3D aspect)
+		imageCreateInfo.mipLevels = 1;											// Number of mipmap levels
+		imageCreateInfo.arrayLayers = 1;										// Number of levels in image array
+		imageCreateInfo.format = swapChainImageFormat;							// Format type of image
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;						// How image data should be "tiled" (arranged for optimal reading)
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;				// Layout of image data on creation
+		imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;	// Rendered to, then can be copied out
+		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;						// Number of samples for multi-sampling
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;				// Whether image can be shared between queues
+
+		SwapChainImage offscreenImage = {};
+		VkResult result = vkCreateImage(mainDevice.logicalDevice, &imageCreateInfo, nullptr, &offscreenImage.image);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create an Offscreen Image!");
+		}
+
+		// Get memory requirements for a type of image
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(mainDevice.logicalDevice, offscreenImage.image, &memoryRequirements);
+
+		VkMemoryAllocateInfo memoryAllocInfo = {};
+		memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryAllocInfo.allocationSize = memoryRequirements.size;
+		memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(mainDevice.physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkDeviceMemory imageMemory;
+		result = vkAllocateMemory(mainDevice.logicalDevice, &memoryAllocInfo, nullptr, &imageMemory);
+		if (result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate memory for Offscreen Image!");
+		}
+
+		vkBindImageMemory(mainDevice.logicalDevice, offscreenImage.image, imageMemory, 0);
+
+		offscreenImage.imageView = CreateImageView(offscreenImage.image, swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		swapChainImages.push_back(offscreenImage);
+		offscreenImageMemory.push_back(imageMemory);
+	}
+
+	printf("Offscreen targets: %i x %ux%u\n", OFFSCREEN_IMAGE_COUNT, swapChainExtent.width, swapChainExtent.height);
+	printf("----------------------------------\n");
+}
+
+bool VulkanRenderer::RecreateSwapChain()
+{
+	// Minimised window has no surface area, swapchain can't be created until it is restored
+	int width = 0;
+	int height = 0;
+	glfwGetFramebufferSize(window, &width, &height);
+	if (width == 0 || height == 0)
+	{
+		swapChainOutdated = true;
+		return false;
+	}
+
+	printf("STAGE: Recreate Swap Chain\n\n");
+
+	// Only work already submitted can use swapchain resources, wait for it instead of whole device
+	frameTimeline.Wait(frameTimeline.GetLastSignalValue());
+
+	// Destroy resources that depend on swapchain images (swapchain itself is handed over as oldSwapchain)
+	for (VkFramebuffer& frameBuffer : swapChainFrameBuffers)
+	{
+		vkDestroyFramebuffer(mainDevice.logicalDevice, frameBuffer, nullptr);
+	}
+	for (SwapChainImage& image : swapChainImages)
+	{
+		vkDestroyImageView(mainDevice.logicalDevice, image.imageView, nullptr);
+	}
+	vkFreeCommandBuffers(mainDevice.logicalDevice, graphicsCommandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+
+	VkFormat oldImageFormat = swapChainImageFormat;
+	CreateSwapChain();
+
+	// Render pass (and pipeline compatible with it) only depends on image format, which normally stays the same
+	if (swapChainImageFormat != oldImageFormat)
+	{
+		pipelineRegistry.Clear();
+		pipelineLibrary.Clear();
+		vkDestroyRenderPass(mainDevice.logicalDevice, renderPass, nullptr);
+		CreateRenderPass();
+		CreateGraphicsPipeline();
+
+		// Materials fall back to default pipeline again until rebuilt for new render pass
+		for (Material& material : materials)
+		{
+			material.description.colorFormat = swapChainImageFormat;
+			material.pipeline = pipelineRegistry.Get(material.description);
+		}
+	}
+
+	CreateFrameBuffers();
+	CreateCommandBuffers();
+
+	// New images have never been rendered to
+	imageTimelineValues.assign(swapChainImages.size(), 0);
+
+	// Readback buffers are sized for old extent
+	if (frameReadback.IsActive())
+	{
+		frameReadback.Collect(&frameTimeline);
+		frameReadback.Destroy();
+		frameReadback.Init(mainDevice.physicalDevice, mainDevice.logicalDevice, swapChainExtent, swapChainImageFormat, readbackCallback);
+	}
+
+	// Y4M stream has one frame size for whole file
+	VkExtent2D captureExtent = videoCapture.GetExtent();
+	if (videoCapture.IsActive() && (captureExtent.width != swapChainExtent.width || captureExtent.height != swapChainExtent.height))
+	{
+		printf("Swapchain resized, video capture stopped\n");
+		videoCapture.Destroy();
+	}
+
+	swapChainOutdated = false;
+	return true;
+}
+
+void VulkanRenderer::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
+{
+	VulkanRenderer* renderer = reinterpret_cast<VulkanRenderer*>(glfwGetWindowUserPointer(window));
+	renderer->framebufferResized = true;
+}
+
 void VulkanRenderer::CreateRenderPass()
 {
 	printf("STAGE: Create Render Pass\n\n");
@@ -718,6 +1492,10 @@ void VulkanRenderer::CreateRenderPass()
 	// to give optimal use for certain operations
 	colourAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;			// Image data layout before render pass starts
 	colourAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;		// Image data layout affter render pass (to change to)
+	if (headless)
+	{
+		colourAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;	// Offscreen images are ready to be copied out
+	}
 
 
 	// Attachment reference uses an attachment index that refers to index in the attachment list passed to renderPassCreateInfo
@@ -756,6 +1534,14 @@ void VulkanRenderer::CreateRenderPass()
 	subpassDependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 	subpassDependencies[1].dependencyFlags = 0;
 
+	// Image may be copied out after render pass (readback, video capture), copy barriers start their source scope at transfer stage
+	// so they are ordered after final layout transition above
+	if (swapChainTransferSrc)
+	{
+		subpassDependencies[1].dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		subpassDependencies[1].dstAccessMask |= VK_ACCESS_TRANSFER_READ_BIT;
+	}
+
 	// Create info for Render Pass
 	VkRenderPassCreateInfo renderPassCreateInfo = {};
 	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -780,19 +1566,142 @@ void VulkanRenderer::CreateGraphicsPipeline()
 {
 	printf("STAGE: Create Graphics Pipeline\n\n");
 
+	// Pipeline layouts are not made here, every pipeline gets one derived from it's shaders (shared by compatible pipelines)
+
+	// Default pipeline is the fallback for materials still compiling, it is compiled in background like them
+	// Nothing waits for it: frames before it is ready are only cleared (layout below needs shader modules, not the pipeline)
+	pipelineLibrary.Init(mainDevice.logicalDevice, renderPass, &pipelineFeedback, &shaderModules);
+	std::string vertexShaderFile;
+	std::string fragmentShaderFile;
+	GetDefaultShaderFiles(vertexShaderFile, fragmentShaderFile);
+	defaultPipelineDescription = MakePipelineDescription(vertexShaderFile, fragmentShaderFile);
+	defaultPipeline = pipelineRegistry.Get(defaultPipelineDescription);
+	defaultPipelineLayout = pipelineLayouts.Get(defaultPipelineDescription);
+	if (defaultPipelineLayout.pushConstantRange.size < sizeof(ObjectPushConstants))
+	{
+		printf("Default shaders have no object push constants, drawing objects untransformed\n");
+	}
+
+	printf("----------------------------------\n");
+}
+
+PipelineDescription VulkanRenderer::MakePipelineDescription(const std::string& vertexShaderFile, const std::string& fragmentShaderFile)
+{
+	PipelineDescription description;
+	description.vertexShaderFile = vertexShaderFile;
+	description.fragmentShaderFile = fragmentShaderFile;
+	description.vertexStride = sizeof(Vertex);
+
+	// How the data for a attribute is defined with a vertex (checked against vertex shader inputs when built)
+	std::vector<VkVertexInputAttributeDescription>& attributeDescriptions = description.vertexAttributes;
+	attributeDescriptions.resize(2);
+
+	// Position Atribute
+	attributeDescriptions[0].binding = 0;								// Which binding the data is at (should be same as above)
+	attributeDescriptions[0].location = 0;								// Location in shader where data will be read from
+	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;		// Format the data will take (also helps define size of data)
+	attributeDescriptions[0].offset = offsetof(Vertex, vertexPosition);	// Where this attribute is defined in the data for a single vertex
+
+	// Colour Attribute
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+	attributeDescriptions[1].offset = offsetof(Vertex, vertexColor);
+
+	description.colorFormat = swapChainImageFormat;			// Render pass is compatible as long as format stays the same
+	description.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;	// Projection flips Y, so meshes seen from camera wind counter clockwise
+
+	// Everything device can set while recording is left out of pipeline
+	if (optionalFeatures.extendedDynamicState)
+	{
+		description.dynamicStates |= PIPELINE_DYNAMIC_CULL_MODE | PIPELINE_DYNAMIC_FRONT_FACE | PIPELINE_DYNAMIC_TOPOLOGY;
+	}
+	if (optionalFeatures.extendedDynamicState2)
+	{
+		description.dynamicStates |= PIPELINE_DYNAMIC_PRIMITIVE_RESTART;
+	}
+	if (optionalFeatures.dynamicPolygonMode)
+	{
+		description.dynamicStates |= PIPELINE_DYNAMIC_POLYGON_MODE;
+	}
+	if (optionalFeatures.dynamicBlend)
+	{
+		description.dynamicStates |= PIPELINE_DYNAMIC_BLEND;
+	}
+
+	return description;
+}
+
+void VulkanRenderer::ReloadChangedShaders()
+{
+	for (const std::string& shaderFile : shaderWatcher.TakeChanges())
+	{
+		// Forget old module and library parts, so rebuilt pipelines pick up new shader
+		shaderModules.Invalidate(shaderFile);
+		pipelineLibrary.Invalidate(shaderFile);
+
+		// Old pipelines keep drawing until rebuilt ones are ready (or for good, if shader does not compile)
+		uint32_t reloaded = pipelineRegistry.Reload(shaderFile);
+		if (reloaded > 0)
+		{
+			printf("Shader changed: %s, rebuilding %u pipelines\n", shaderFile.c_str(), reloaded);
+		}
+	}
+}
+
+void VulkanRenderer::RefreshPipelineLayouts(const std::vector<PipelineHandle>& reloadedPipelines)
+{
+	for (PipelineHandle handle : reloadedPipelines)
+	{
+		// Materials look their layout up again on next draw
+		for (Material& material : materials)
+		{
+			if (material.pipeline == handle)
+			{
+				material.layout = PipelineLayoutInfo();
+			}
+		}
+
+		if (handle != defaultPipeline)
+		{
+			continue;
+		}
+
+		// Rebuilt pipeline's shader modules are cached, so this is a lookup, not a compile
+		defaultPipelineLayout = pipelineLayouts.Get(defaultPipelineDescription);
+
+		// Scene ring's descriptor set has to match new scene set layout (if there still is one)
+		bool hasSceneSet = defaultPipelineLayout.setLayouts.size() > SCENE_DESCRIPTOR_SET;
+		if (sceneUniforms.IsActive() && (!hasSceneSet || sceneUniforms.GetSetLayout() != defaultPipelineLayout.setLayouts[SCENE_DESCRIPTOR_SET]))
+		{
+			// Rare (shader edit changed scene block), frames in flight still bind old set
+			frameTimeline.Wait(frameTimeline.GetLastSignalValue());
+			sceneUniforms.Destroy();
+		}
+		if (!sceneUniforms.IsActive())
+		{
+			CreateSceneUniforms();
+		}
+	}
+}
+
+VkPipeline VulkanRenderer::BuildGraphicsPipeline(VkPipelineCache cache, const PipelineDescription& description, PipelineBuildPass pass)
+{
+	// Layout comes from shader reflection, vertex input is checked against it (loads shader modules)
+	pipelineLayouts.ValidateVertexInput(description);
+	VkPipelineLayout pipelineLayout = pipelineLayouts.Get(description).layout;
+
+	// Link from shared parts if device can, otherwise whole pipeline is compiled in one go
+	if (optionalFeatures.graphicsPipelineLibrary)
+	{
+		return pipelineLibrary.Link(cache, description, pipelineLayout, pass == PIPELINE_BUILD_OPTIMIZED);
+	}
+
 	// -- SHADER MODULES --
 	
-	// Read in SPIR-V code in shaders
-	printf("Load Vertex shader SPIR-V code\n");
-	auto vertexShaderCode = readFile("../Shaders/vert.spv");
-	printf("Load Fragment shader SPIR-V code\n");
-	auto fragmentShaderCode = readFile("../Shaders/frag.spv");
-
-	// Create shader modules
-	printf("Create Vertex shader module\n");
-	VkShaderModule vertexShaderModule = CreateShaderModule(vertexShaderCode);
-	printf("Create Fragment shader module\n");
-	VkShaderModule fragmentShaderModule = CreateShaderModule(fragmentShaderCode);
+	// Modules are shared by every pipeline using same SPIR-V, cache maps and loads each file once
+	VkShaderModule vertexShaderModule = shaderModules.Get(description.vertexShaderFile);
+	VkShaderModule fragmentShaderModule = shaderModules.Get(description.fragmentShaderFile);
 
 	// Vertex Stage creation information
 	VkPipelineShaderStageCreateInfo vertexShaderCreateInfo = {};
@@ -800,6 +1709,11 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;							// Shader stage name
 	vertexShaderCreateInfo.module = vertexShaderModule;									// Shader module to be used by stage
 	vertexShaderCreateInfo.pName = "main";												// Entry point in to shader
+
+	// Specialization constants of each stage (have to stay alive until pipeline is created)
+	ShaderSpecialization vertexSpecialization;
+	description.GetSpecialization(VK_SHADER_STAGE_VERTEX_BIT, vertexSpecialization);
+	vertexShaderCreateInfo.pSpecializationInfo = vertexSpecialization.Get();
 																			// Fragment Stage creation information
 	VkPipelineShaderStageCreateInfo fragmentShaderCreateInfo = {};
 	fragmentShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -807,6 +1721,10 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	fragmentShaderCreateInfo.module = fragmentShaderModule;								// Shader module to be used by stage
 	fragmentShaderCreateInfo.pName = "main";											// Entry point in to shader
 
+	ShaderSpecialization fragmentSpecialization;
+	description.GetSpecialization(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentSpecialization);
+	fragmentShaderCreateInfo.pSpecializationInfo = fragmentSpecialization.Get();
+
 	// Put shader stage creation info in to array
 	// Graphics Pipeline creation info requires array of shader stage creates
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderCreateInfo, fragmentShaderCreateInfo };
@@ -815,50 +1733,36 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	// How the data for a single vertex (including info such as position, colour, texture coords, normals, etc) is a whole
 	VkVertexInputBindingDescription bindingDescription = {};
 	bindingDescription.binding = 0;										// Can bind multiple streams of data, this defines which one
-	bindingDescription.stride = sizeof(Vertex);							// Size of single object
-	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;			// How to move vertex date after each vertex.
+	bindingDescription.stride = description.vertexStride;				// Size of single object
+	bindingDescription.inputRate = description.vertexInputRate;			// How to move vertex date after each vertex.
 																		// VK_VERTEX_INPUT_RATE_VERTEX		: Move on the next vertex
 																		// VK_VERTEX_INPUT_RATE_INSTANCE	: Move to a vertex the next instance
 
-	// How the data for a attribute	is defined with a vertex
-	std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions;
-	
-	// Position Atribute
-	attributeDescriptions[0].binding = 0;								// Which binding the data is at (should be same as above)
-	attributeDescriptions[0].location = 0;								// Location in shader where data will be read from
-	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;		// Format the data will take (also helps define size of data)
-	attributeDescriptions[0].offset = offsetof(Vertex, vertexPosition);	// Where this attribute is defined in the data for a single vertex
-
-	// Colour Attribute: TODO
-	attributeDescriptions[1].binding = 0;								// Which binding the data is at (should be same as above)
-	attributeDescriptions[1].location = 1;								// Location in shader where data will be read from
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;		// Format the data will take (also helps define size of data)
-	attributeDescriptions[1].offset = offsetof(Vertex, vertexColor);	// Where this attribute is defined in the data for a single vertex
-
 	// -- VERTEX INPUT --
 	printf("Create Vertex input state\n");
 	VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
 	vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
 	vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;											// List of vertex binding descriptors (data spacing/stride infos)
-	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();								// List of vertex attribute descriptors (data format and where to bind to/from)
+	vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+	vertexInputCreateInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();								// List of vertex attribute descriptors (data format and where to bind to/from)
 		
 	
 	// -- INPUT ASSEMBLY -- 
 	printf("Create Pipeline input assembly state\n");
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;			// Primitive type to assemble vertices as
-	inputAssembly.primitiveRestartEnable = VK_FALSE;						// Allow overriding of "strip" topology to start new primitive
+	inputAssembly.topology = description.topology;							// Primitive type to assemble vertices as
+	inputAssembly.primitiveRestartEnable = description.primitiveRestartEnable;						// Allow overriding of "strip" topology to start new primitive
 
 	
 	// -- VIEWPORT AND SCISSOR --
+	// Viewport and scissor are dynamic (set while recording), values here are ignored so pipeline does not depend on swapchain size
 	VkViewport viewPort = {};
 	viewPort.x = 0.0f;									// x start coordinate
 	viewPort.y = 0.0f;									// y start coordinage
-	viewPort.width = (float)swapChainExtent.width;		// width view port
-	viewPort.height = (float)swapChainExtent.height;	// height view port
+	viewPort.width = 1.0f;								// width view port
+	viewPort.height = 1.0f;								// height view port
 	viewPort.minDepth = 0.0f;							// min framebuffer depth
 	viewPort.maxDepth = 1.0f;							// max framebuffer depth
 	printf("Create Viewport with { offset_x: %.2f, offset_y: %.2f, width: %.2f, height: %.2f, minDepth: %.2f, maxDepth: %.2f }\n", viewPort.x, viewPort.y, viewPort.width, viewPort.height, viewPort.minDepth, viewPort.maxDepth);
@@ -866,7 +1770,7 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	// Create a scissor info struct
 	VkRect2D scissor = {};
 	scissor.offset = { 0, 0 };							// Offset to use region from
-	scissor.extent = { swapChainExtent };				// Extent to descripe region to use
+	scissor.extent = { 1, 1 };							// Extent to descripe region to use
 	printf("Create Scissor with { offset_x: %.2f, offset_y: %.2f, width: %.2f, height: %.2f }\n", (float)scissor.offset.x, (float)scissor.offset.y, (float)scissor.extent.width, (float)scissor.extent.height);
 
 	VkPipelineViewportStateCreateInfo viewPortStateCreateInfo = {};
@@ -877,16 +1781,45 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	viewPortStateCreateInfo.pScissors = &scissor;
 
 	// -- DYNAMIC STATES --
-	//std::vector<VkDynamicState> dynamicStateEnables;
-	//dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);		// Dynamic viewport : Can resize in command buffer with vkCmdSetViewport(commandbuffer, 0, 1, &viewport);
-	//dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);		// Dynamic scissor  : Can resize in command buffer with vkCmdSetScissor(commandbuffer, 0, 1, &scissor);
+	// Viewport and scissor are dynamic so swapchain can be recreated (window resize) without rebuilding pipeline
+	std::vector<VkDynamicState> dynamicStateEnables;
+	dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);		// Dynamic viewport : Can resize in command buffer with vkCmdSetViewport(commandbuffer, 0, 1, &viewport);
+	dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);		// Dynamic scissor  : Can resize in command buffer with vkCmdSetScissor(commandbuffer, 0, 1, &scissor);
+
+	// Extended dynamic state: set per draw from material description (see SetDynamicState)
+	if (description.dynamicStates & PIPELINE_DYNAMIC_CULL_MODE)
+	{
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_FRONT_FACE)
+	{
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_TOPOLOGY)
+	{
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_PRIMITIVE_RESTART)
+	{
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_POLYGON_MODE)
+	{
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_BLEND)
+	{
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+	}
 
 	// Dynamic State creation info
 	printf("Create Dynamic States\n");
-	//VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
-	//dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	//dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-	//dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
+	VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
+	dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
+	dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
 
 	// -- RASTERIZER --
 	printf("Create Rasterization State\n");
@@ -894,10 +1827,10 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	rasterizationStateCreateInfo.depthClampEnable = VK_FALSE;			// Change if fragment beyond near/far planes are clipped (default) or clamped to plane
 	rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;	// Whether to discard data and skip resterizer. Never creates fragment, only suitable for pipeline without framebuffer output
-	rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;	// How to handle filling points between vertices
+	rasterizationStateCreateInfo.polygonMode = description.polygonMode;	// How to handle filling points between vertices
 	rasterizationStateCreateInfo.lineWidth = 1.0f;						// How thick line should be when drawn
-	rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;		// Which face of a tri to cull
-	rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;	// Winding to determine which side is front
+	rasterizationStateCreateInfo.cullMode = description.cullMode;		// Which face of a tri to cull
+	rasterizationStateCreateInfo.frontFace = description.frontFace;		// Winding to determine which side is front
 	rasterizationStateCreateInfo.depthBiasEnable = VK_FALSE;			// Whether to add depth bias to fragments (good for stopping "shadow acne" in shadow mapping)
 
 	// -- MULTISAMPLING --
@@ -905,30 +1838,27 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo = {};
 	multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampleStateCreateInfo.sampleShadingEnable = VK_FALSE;					// Enable multisample shading or not
-	multisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;	// Number of samples to use per fragment
+	multisampleStateCreateInfo.rasterizationSamples = description.sampleCount;	// Number of samples to use per fragment
 
 	// -- BLENDING --
 	// Blending decides how to blend a new color being a fragment, with the old value
 	
 	// Blend Attachment State (how blending is handled)
 	VkPipelineColorBlendAttachmentState colorBlendAttachmentState = {};
-	colorBlendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT		// Colors to apply blending to 
-		| VK_COLOR_COMPONENT_G_BIT 
-		| VK_COLOR_COMPONENT_B_BIT 
-		| VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachmentState.blendEnable = VK_TRUE;						// Enable blending
+	colorBlendAttachmentState.colorWriteMask = description.colorWriteMask;	// Colors to apply blending to 
+	colorBlendAttachmentState.blendEnable = description.blendEnable;		// Enable blending
 
 	// Blending uses equation: (srcColorBlendFactor * new color) colorBlendOp(destinationBlendFactor * old Color)
 	// Summarised:	(VK_BLEND_FACTOR_SRC_ALPHA * new color) + (VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA * old color)
 	//				(new color alpha * new color) + ((1 - new color alpha) * old color)
-	colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-	colorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachmentState.srcColorBlendFactor = description.srcColorBlendFactor;
+	colorBlendAttachmentState.dstColorBlendFactor = description.dstColorBlendFactor;
+	colorBlendAttachmentState.colorBlendOp = description.colorBlendOp;
 	
 	// Summarised: (1 * new alpha) + (0 * old alpha)
-	colorBlendAttachmentState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachmentState.srcAlphaBlendFactor = description.srcAlphaBlendFactor;
+	colorBlendAttachmentState.dstAlphaBlendFactor = description.dstAlphaBlendFactor;
+	colorBlendAttachmentState.alphaBlendOp = description.alphaBlendOp;
 
 	printf("Create Blending State\n");
 	VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo = {};
@@ -938,23 +1868,6 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
 
 
-	// -- PIPELINE LAYOUT -- (TODO: Apply Future Descriptors Layouts)
-	printf("Create Pipeline Layout\n");
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutCreateInfo.setLayoutCount = 0;
-	pipelineLayoutCreateInfo.pSetLayouts = nullptr;
-	pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-
-	// Create Pipeline Layout
-	VkResult result = vkCreatePipelineLayout(mainDevice.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create Pipeline Layout!");
-	}
-
-
 	// -- DEPTH STENCIL TESTING --
 	//	TODO: Set up depth stencil testing
 	printf("Create Depth Stencil Testing\n");
@@ -967,7 +1880,7 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;				// Vertex Input State
 	pipelineCreateInfo.pInputAssemblyState = &inputAssembly;					// Assembly State
 	pipelineCreateInfo.pViewportState = &viewPortStateCreateInfo;				// ViewPort State
-	pipelineCreateInfo.pDynamicState = nullptr;									// Dynamic State
+	pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;					// Dynamic State
 	pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;		// Fragment/Resterization State
 	pipelineCreateInfo.pMultisampleState = &multisampleStateCreateInfo;			// Multisamples State
 	pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;			// Color Blend State
@@ -980,23 +1893,96 @@ void VulkanRenderer::CreateGraphicsPipeline()
 	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;						// Existing pipeline for derive from ...
 	pipelineCreateInfo.basePipelineIndex = -1;									// or index of pipeline being created to derive from (in case creating multiple at once)
 
-	// Create Graphics Pipeline
-	result = vkCreateGraphicsPipelines(mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline);
+	// Create Graphics Pipeline (driver skips compilation if cache already has it)
+	PipelineFeedbackRecord feedback;
+	pipelineFeedback.Attach(pipelineCreateInfo, feedback);
+
+	VkPipeline pipeline;
+	auto createStart = std::chrono::high_resolution_clock::now();
+	VkResult result = vkCreateGraphicsPipelines(mainDevice.logicalDevice, cache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+	double createMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - createStart).count();
 	if (result != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create a Graphics Pipeline!");
 	}
+	pipelineFeedback.Report(feedback, "monolithic");
 
-	printf("Graphics Pipeline created successful\n");
+	printf("Graphics Pipeline created successful (%.2f ms, %s cache)\n", createMs, pipelineCache.WasLoaded() ? "warm" : "cold");
 
-	printf("Destroy shader modules:\n");
-	// Destroy shader modules, no longer needed after Pipeline created
-	printf("Destroy Vertex shader module\n");
-	vkDestroyShaderModule(mainDevice.logicalDevice, fragmentShaderModule, nullptr);
-	printf("Destroy Fragment shader module\n");
-	vkDestroyShaderModule(mainDevice.logicalDevice, vertexShaderModule, nullptr);
+	return pipeline;
+}
 
-	printf("----------------------------------\n");
+void VulkanRenderer::SetDynamicState(CommandEncoder& encoder, const PipelineDescription& description)
+{
+	// Called after every pipeline bind, encoder forgets extended dynamic state when pipeline changes and drops the rest as redundant
+	if (description.dynamicStates & PIPELINE_DYNAMIC_CULL_MODE)
+	{
+		encoder.SetCullMode(description.cullMode);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_FRONT_FACE)
+	{
+		encoder.SetFrontFace(description.frontFace);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_TOPOLOGY)
+	{
+		encoder.SetPrimitiveTopology(description.topology);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_PRIMITIVE_RESTART)
+	{
+		encoder.SetPrimitiveRestartEnable(description.primitiveRestartEnable);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_POLYGON_MODE)
+	{
+		encoder.SetPolygonMode(description.polygonMode);
+	}
+	if (description.dynamicStates & PIPELINE_DYNAMIC_BLEND)
+	{
+		VkColorBlendEquationEXT equation = {};
+		equation.srcColorBlendFactor = description.srcColorBlendFactor;
+		equation.dstColorBlendFactor = description.dstColorBlendFactor;
+		equation.colorBlendOp = description.colorBlendOp;
+		equation.srcAlphaBlendFactor = description.srcAlphaBlendFactor;
+		equation.dstAlphaBlendFactor = description.dstAlphaBlendFactor;
+		equation.alphaBlendOp = description.alphaBlendOp;
+
+		encoder.SetColorBlendEnable(description.blendEnable);
+		encoder.SetColorBlendEquation(equation);
+		encoder.SetColorWriteMask(description.colorWriteMask);
+	}
+}
+
+VkPipeline VulkanRenderer::GetMaterialPipeline(int materialIndex, const PipelineLayoutInfo*& layout)
+{
+	// Pointer, not a copy: layout info holds a vector and this runs for every draw
+	layout = &defaultPipelineLayout;
+	if (materialIndex < 0 || materialIndex >= (int)materials.size())
+	{
+		return pipelineRegistry.GetIfReady(defaultPipeline);
+	}
+
+	Material& material = materials[materialIndex];
+	VkPipeline pipeline = pipelineRegistry.GetIfReady(material.pipeline);
+	if (pipeline != VK_NULL_HANDLE)
+	{
+		// Pipeline build already created this layout, so lookup is only a cache hit
+		if (material.layout.layout == VK_NULL_HANDLE)
+		{
+			material.layout = pipelineLayouts.Get(material.description);
+		}
+		layout = &material.layout;
+		return pipeline;
+	}
+
+	// Still compiling (or failed), default pipeline may not be ready yet either
+	VkPipeline fallback = material.useFallback ? pipelineRegistry.GetIfReady(defaultPipeline) : VK_NULL_HANDLE;
+	if (fallback != VK_NULL_HANDLE)
+	{
+		framePacing.fallbackDraws++;
+		return fallback;
+	}
+
+	framePacing.skippedDraws++;
+	return VK_NULL_HANDLE;
 }
 
 void VulkanRenderer::CreateFrameBuffers()
@@ -1040,6 +2026,7 @@ void VulkanRenderer::CreateCommandPool()
 
 	VkCommandPoolCreateInfo poolInfo = {};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// Buffers are re-recorded every frame, so allow resetting them one by one
 	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;		// Queue Family type buffers from this command pool will use
 
 	// Create a Graphics Queue Family Command Pool
@@ -1080,37 +2067,184 @@ void VulkanRenderer::CreateCommandBuffers()
 
 void VulkanRenderer::CreateSynchronisation()
 {
-	imageAvaible.resize(MAX_FRAME_DRAWS);
-	renderFinished.resize(MAX_FRAME_DRAWS);
-	drawFences.resize(MAX_FRAME_DRAWS);
+	frameTimeline.Init(mainDevice.logicalDevice);
+	CreateFrameSlots();
+
+	lastDrawTime = std::chrono::high_resolution_clock::now();
+	lastReportTime = lastDrawTime;
+}
+
+void VulkanRenderer::CreateFrameSlots()
+{
+	imageAvaible.resize(framesInFlight);
+	renderFinished.resize(framesInFlight);
+
+	// Frame slots start at 0, value timeline is already at (nothing to wait for)
+	frameTimelineValues.assign(framesInFlight, 0);
+	currentFrame = 0;
 
-	// Semaphore creation information
+	// Semaphore creation information (binary semaphores, presentation engine can't use timeline ones)
 	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
 	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	// Fence creation information
-	VkFenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	for (size_t i = 0; i < MAX_FRAME_DRAWS; i++)
+	for (int i = 0; i < framesInFlight; i++)
 	{
 		if (vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &imageAvaible[i]) != VK_SUCCESS ||
-			vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &renderFinished[i]) != VK_SUCCESS ||
-			vkCreateFence(mainDevice.logicalDevice, &fenceCreateInfo, nullptr, &drawFences[i]) != VK_SUCCESS)
+			vkCreateSemaphore(mainDevice.logicalDevice, &semaphoreCreateInfo, nullptr, &renderFinished[i]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create a Semaphores!");
+		}
+	}
+}
+
+void VulkanRenderer::DestroyFrameSlots()
+{
+	for (size_t i = 0; i < imageAvaible.size(); i++)
+	{
+		vkDestroySemaphore(mainDevice.logicalDevice, imageAvaible[i], nullptr);
+		vkDestroySemaphore(mainDevice.logicalDevice, renderFinished[i], nullptr);
+	}
+	imageAvaible.clear();
+	renderFinished.clear();
+}
+
+void VulkanRenderer::ReportFramePacing()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+	framePacing.frameTimeMs += std::chrono::duration<double, std::milli>(now - lastDrawTime).count();
+	framePacing.frameCount++;
+	lastDrawTime = now;
+
+	// Report about every 2 seconds
+	if (std::chrono::duration<double>(now - lastReportTime).count() < 2.0)
+	{
+		return;
+	}
+
+	double frames = (double)framePacing.frameCount;
+	double frameMs = framePacing.frameTimeMs / frames;
+	double waitMs = (framePacing.frameSlotWaitMs + framePacing.imageWaitMs) / frames;
+	printf("Frames in flight: %i | frame: %.2f ms | CPU blocked on GPU: %.2f ms (%.0f%%) | GPU queue depth: %.2f frames\n",
+		framesInFlight, frameMs, waitMs, frameMs > 0.0 ? 100.0 * waitMs / frameMs : 0.0, (double)framePacing.queuedFrames / frames);
+	if (!headless)
+	{
+		printf("Present mode: %s | submit to %s: %.2f ms | CPU blocked on present: %.2f ms\n",
+			presentModeKHRString(presentMode).c_str(), optionalFeatures.presentWait ? "on screen" : "GPU finished",
+			framePacing.presentedFrames > 0 ? framePacing.presentLatencyMs / framePacing.presentedFrames : 0.0, framePacing.presentWaitMs / frames);
+	}
+	printf("Binds issued: %u, binds skipped: %u, draw calls: %u\n", recordStats.bindsIssued, recordStats.bindsSkipped, recordStats.drawCalls);
+	if (!materials.empty())
+	{
+		PipelineRegistryStats registryStats = pipelineRegistry.GetStats();
+		printf("Pipelines: %u (registry hits %u, misses %u, optimized %u, reloaded %u) | library parts: %u | compiling: %u | fallback draws: %u | skipped draws: %u\n",
+			registryStats.pipelineCount, registryStats.hits, registryStats.misses, registryStats.optimizedCount, registryStats.reloadCount, pipelineLibrary.GetPartCount(),
+			pipelineCompiler.GetPendingCount(), framePacing.fallbackDraws, framePacing.skippedDraws);
+	}
+	PipelineCreationStats creationStats = pipelineFeedback.GetStats();
+	if (creationStats.pipelineCount > 0)
+	{
+		printf("Pipeline creation: %u created, cache hits %u (stages %u/%u), driver time %.2f ms\n",
+			creationStats.pipelineCount, creationStats.cacheHits, creationStats.stageCacheHits, creationStats.stageCount, creationStats.creationMs);
+	}
+	recordStats = EncoderStats();
+
+	lastFramePacing = framePacing;
+	framePacing = FramePacingStats();
+	lastReportTime = now;
+}
+
+void VulkanRenderer::ReportPresentLatency()
+{
+	// CPU clock from frame's vkQueueSubmit call until frame was seen presented (or GPU finished it, without present wait)
+	printf("Present latency (CPU time from vkQueueSubmit call to %s):\n", optionalFeatures.presentWait ? "frame on screen" : "GPU finished frame");
+	for (const auto& modeLatency : presentLatency)
+	{
+		const PresentLatencyStats& latency = modeLatency.second;
+		if (latency.frameCount == 0)
+		{
+			continue;
+		}
+
+		printf("\t%s: %u frames, avg %.2f ms, min %.2f ms, max %.2f ms\n", presentModeKHRString(modeLatency.first).c_str(),
+			latency.frameCount, latency.totalMs / latency.frameCount, latency.minMs, latency.maxMs);
+	}
+}
+
+void VulkanRenderer::ReportShaderCompilation()
+{
+	ShaderCompilerStats stats = shaderCompiler.GetStats();
+	printf("Shaders: %u compiled, %u from disk cache, %u failed (optimizer stage %s)\n", stats.compiledCount, stats.cacheHits, stats.failedCount,
+		shaderCompiler.IsOptimizing() ? "on" : "off");
+	if (stats.optimizedCount > 0)
+	{
+		printf("\t%u optimized: %llu -> %llu bytes (%.1f%%), %llu -> %llu instructions (%.1f%%)\n", stats.optimizedCount,
+			(unsigned long long)stats.bytesBefore, (unsigned long long)stats.bytesAfter, 100.0 * stats.bytesAfter / stats.bytesBefore,
+			(unsigned long long)stats.instructionsBefore, (unsigned long long)stats.instructionsAfter,
+			100.0 * stats.instructionsAfter / (stats.instructionsBefore > 0 ? stats.instructionsBefore : 1));
+	}
+}
+
+bool VulkanRenderer::IsPresented(const PresentTiming& frame, uint64_t timeout)
+{
+	// Without present wait (or for frames of a retired swapchain) GPU finishing frame is closest point we can observe
+	if (!optionalFeatures.presentWait || frame.presentId < swapChainFirstPresentId)
+	{
+		if (timeout == 0)
 		{
-			throw std::runtime_error("Failed to create a Semaphores and/or Fences!");
+			return frameTimeline.IsReached(frame.timelineValue);
 		}
+
+		frameTimeline.Wait(frame.timelineValue);
+		return true;
+	}
+
+	VkResult result = fpWaitForPresentKHR(mainDevice.logicalDevice, swapChain, frame.presentId, timeout);
+	if (result == VK_TIMEOUT)
+	{
+		return false;
+	}
+	else if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+	{
+		// Frame will never show up on this swapchain, rebuild and stop waiting for it
+		swapChainOutdated = true;
+	}
+	else if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to wait for Present!");
+	}
+
+	return true;
+}
+
+void VulkanRenderer::CollectPresentTimings()
+{
+	// Frames reach screen in order, stop at first one that is not there yet
+	// Polled frames are measured when noticed, so only WaitForPresent gives exact latency
+	auto now = std::chrono::high_resolution_clock::now();
+	while (!pendingPresents.empty() && IsPresented(pendingPresents.front(), 0))
+	{
+		const PresentTiming& frame = pendingPresents.front();
+		double latencyMs = std::chrono::duration<double, std::milli>(now - frame.submitTime).count();
+
+		PresentLatencyStats& latency = presentLatency[frame.presentMode];
+		latency.minMs = latency.frameCount == 0 ? latencyMs : std::min(latency.minMs, latencyMs);
+		latency.maxMs = std::max(latency.maxMs, latencyMs);
+		latency.totalMs += latencyMs;
+		latency.frameCount++;
+
+		framePacing.presentLatencyMs += latencyMs;
+		framePacing.presentedFrames++;
+
+		pendingPresents.pop_front();
 	}
 }
 
-void VulkanRenderer::RecordCommands()
+void VulkanRenderer::RecordCommands(uint32_t imageIndex, const FramePacket& packet)
 {
-	printf("STAGE: Record Commands \n\n");
-	// Information about how to begin each command buffer
+	// Information about how to begin command buffer
 	VkCommandBufferBeginInfo bufferBeginInfo = {};
 	bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;		// Buffer can be resubmitted when it has already been submitted and awaiting execution
+	bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;		// Buffer is re-recorded before every submit
 
 	// Information how te begin Render Pass (only need in graphical application)
 	VkRenderPassBeginInfo renderPassBeginInfo = {};
@@ -1124,41 +2258,157 @@ void VulkanRenderer::RecordCommands()
 	renderPassBeginInfo.pClearValues = clearValues;								// List of clear values (TODO: Depth Attachment Clear)
 	renderPassBeginInfo.clearValueCount = 1;									// Count of clear values
 
-	for (size_t i = 0; i < commandBuffers.size(); i++)
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = (float)swapChainExtent.width;
+	viewport.height = (float)swapChainExtent.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor = {};
+	scissor.offset = { 0, 0 };
+	scissor.extent = swapChainExtent;
+
+	renderPassBeginInfo.framebuffer = swapChainFrameBuffers[imageIndex];
+
+	// Encoder keeps track of bound state and drops binds that change nothing
+	CommandEncoder encoder(commandBuffers[imageIndex], &dynamicStateFunctions);
+
+	// Start recording command in command buffer
+	encoder.Begin(bufferBeginInfo);
+
+	// Statistics queries of this frame are reset before any pass, ring being full just skips measuring it
+	recordedStatisticsSlot = gpuStatistics.BeginFrame(encoder.GetCommandBuffer());
+
+	// Begin Render Pass
+	encoder.BeginRenderPass(renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	gpuStatistics.BeginPass(encoder.GetCommandBuffer(), recordedStatisticsSlot, GPU_PASS_MAIN);
+
+	// Bind Pipeline to be used in render pass (not there while it is still compiling, objects then bind their own or are skipped)
+	VkPipeline pipeline = pipelineRegistry.GetIfReady(defaultPipeline);
+	if (pipeline != VK_NULL_HANDLE)
 	{
-		renderPassBeginInfo.framebuffer = swapChainFrameBuffers[i];
+		encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	}
 
-		// Start recording command in command buffer
-		VkResult result = vkBeginCommandBuffer(commandBuffers[i], &bufferBeginInfo);
-		if (result != VK_SUCCESS)
+	// Scene set stays bound for every pipeline with compatible layout, only dynamic offset changes per frame
+	if (sceneUniforms.IsActive())
+	{
+		VkDescriptorSet sceneSet = sceneUniforms.GetDescriptorSet();
+		uint32_t sceneOffset = sceneUniforms.GetOffset(currentFrame);
+		encoder.BindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, defaultPipelineLayout.layout, SCENE_DESCRIPTOR_SET, 1, &sceneSet, 1, &sceneOffset);
+	}
+
+	// Viewport and scissor follow current swapchain size (dynamic state of pipeline)
+	encoder.SetViewport(viewport);
+	encoder.SetScissor(scissor);
+
+	// Draw every object simulation found visible (objects sharing a mesh don't rebind it)
+	for (const ObjectPacket& object : packet.visibleObjects)
+	{
+		if (object.meshIndex < 0 || object.meshIndex >= (int)meshList.size())
+		{
+			continue;
+		}
+		Mesh& mesh = meshList[object.meshIndex];
+		if (mesh.GetVertexBuffer() == VK_NULL_HANDLE)
 		{
-			throw std::runtime_error("Failed to start recording a Command Buffer!");
+			continue;
 		}
 
-		// Begin Render Pass
-		vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		// Never wait for a material to compile, frame goes on without it
+		const PipelineLayoutInfo* layout = nullptr;
+		pipeline = GetMaterialPipeline(object.materialIndex, layout);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+		encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		PushObjectConstants(encoder, layout, object);
 
-		// Bind Pipeline to be used in render pass
-		vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		// Material's own raster/blend state, also used when drawn with fallback pipeline
+		bool hasMaterial = object.materialIndex >= 0 && object.materialIndex < (int)materials.size();
+		SetDynamicState(encoder, hasMaterial ? materials[object.materialIndex].description : defaultPipelineDescription);
 
-		VkBuffer vertexBuffers[] = { firstMesh.GetVertexBuffer() };					// Buffers to bind
+		VkBuffer vertexBuffers[] = { mesh.GetVertexBuffer() };						// Buffers to bind
 		VkDeviceSize offsets[] = { 0 };												// Offsets into buffers being bound
-		vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);	// Command to bind vertex buffer before drawing with them
+		encoder.BindVertexBuffers(0, 1, vertexBuffers, offsets);					// Command to bind vertex buffer before drawing with them
 
 		// Execute Pipeline
-		vkCmdDraw(commandBuffers[i], static_cast<uint32_t>(firstMesh.GetVertexCount()), 1, 0, 0);
+		encoder.Draw(static_cast<uint32_t>(mesh.GetVertexCount()), 1, 0, 0);
+	}
 
-		// End Render Pass
-		vkCmdEndRenderPass(commandBuffers[i]);
-		result = vkEndCommandBuffer(commandBuffers[i]);
-		if (result != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to end recording a Command Buffer!");
-		}
+	// End Render Pass
+	gpuStatistics.EndPass(encoder.GetCommandBuffer(), recordedStatisticsSlot, GPU_PASS_MAIN);
+	encoder.EndRenderPass();
+
+	// Copy frame out for CPU, ring being full just skips this frame
+	recordedReadbackSlot = -1;
+	if (frameReadback.IsActive() && frameCount % readbackInterval == 0)
+	{
+		VkImageLayout imageLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		recordedReadbackSlot = frameReadback.RecordCopy(encoder.GetCommandBuffer(), swapChainImages[imageIndex].image, imageLayout);
 	}
 
-	printf("Record Commands successful\n");
-	printf("----------------------------------\n");
+	// Copy frame for video stream, YUV conversion is submitted to compute queue after this frame
+	recordedCaptureSlot = -1;
+	if (videoCapture.IsActive())
+	{
+		VkImageLayout imageLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		recordedCaptureSlot = videoCapture.RecordCopy(encoder.GetCommandBuffer(), swapChainImages[imageIndex].image, imageLayout);
+	}
+
+	encoder.End();
+
+	recordStats += encoder.GetStats();
+}
+
+void VulkanRenderer::PushObjectConstants(CommandEncoder& encoder, const PipelineLayoutInfo* layout, const ObjectPacket& object)
+{
+	// Shaders without object block draw in world space as before
+	if (layout->pushConstantRange.size < sizeof(ObjectPushConstants))
+	{
+		return;
+	}
+
+	// Per-draw data goes straight in to command buffer, no buffer write or descriptor update per object
+	ObjectPushConstants constants;
+	constants.model = object.transform;
+	encoder.PushConstants(layout->layout, layout->pushConstantRange.stageFlags, 0, sizeof(constants), &constants);
+}
+
+void VulkanRenderer::CreateSceneUniforms()
+{
+	// Shaders decide if there are scene uniforms at all (precompiled SPIR-V may be older than shader source)
+	if (defaultPipelineLayout.setLayouts.size() <= SCENE_DESCRIPTOR_SET)
+	{
+		printf("Default shaders have no scene uniforms, drawing without camera\n");
+		return;
+	}
+
+	// Slice for every possible frame slot, so changing frames in flight does not rebuild ring
+	sceneUniforms.Init(mainDevice.physicalDevice, mainDevice.logicalDevice, defaultPipelineLayout.setLayouts[SCENE_DESCRIPTOR_SET], 0,
+		sizeof(SceneUniforms), MAX_FRAME_DRAWS);
+}
+
+void VulkanRenderer::UpdateSceneUniforms(const FramePacket& packet)
+{
+	if (!sceneUniforms.IsActive())
+	{
+		return;
+	}
+
+	SceneUniforms uniforms = {};
+	uniforms.view = packet.camera.view;
+
+	// Vulkan clip space has Y pointing down and depth from 0 to 1
+	float aspect = swapChainExtent.height > 0 ? (float)swapChainExtent.width / (float)swapChainExtent.height : 1.0f;
+	uniforms.projection = glm::perspectiveRH_ZO(glm::radians(packet.camera.fieldOfView), aspect, 0.1f, 100.0f);
+	uniforms.projection[1][1] *= -1.0f;
+	uniforms.time = static_cast<float>(packet.simulationTime);
+
+	sceneUniforms.Write(currentFrame, &uniforms, sizeof(uniforms));
 }
 
 void VulkanRenderer::GetPhysicalDevice()
@@ -1199,6 +2449,109 @@ void VulkanRenderer::GetPhysicalDevice()
 	printf("----------------------------------\n");
 }
 
+void VulkanRenderer::GetOptionalFeatures()
+{
+	// Present id/wait let CPU wait until a given frame is on screen, without them latency is measured to GPU completion
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+	presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+	presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	presentWaitFeatures.pNext = &presentIdFeatures;
+
+	VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+	deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	deviceFeatures2.pNext = &presentWaitFeatures;
+
+	bool presentWaitExtensions = !headless && CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME)
+		&& CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	if (presentWaitExtensions)
+	{
+		vkGetPhysicalDeviceFeatures2(mainDevice.physicalDevice, &deviceFeatures2);
+	}
+
+	optionalFeatures.presentWait = presentWaitExtensions && presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+	printf("Present wait: %s\n", optionalFeatures.presentWait ? "supported" : "not supported");
+
+	// Extended dynamic state lets one pipeline serve many raster/blend combinations, each extension is optional on it's own
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicStateFeatures = {};
+	dynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+	VkPhysicalDeviceExtendedDynamicState2FeaturesEXT dynamicState2Features = {};
+	dynamicState2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features = {};
+	dynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+	bool dynamicStateExtension = CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+	bool dynamicState2Extension = CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+	bool dynamicState3Extension = CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+
+	// Only chain structs of extensions device has
+	deviceFeatures2.pNext = nullptr;
+	void** chainEnd = &deviceFeatures2.pNext;
+	if (dynamicStateExtension)
+	{
+		*chainEnd = &dynamicStateFeatures;
+		chainEnd = &dynamicStateFeatures.pNext;
+	}
+	if (dynamicState2Extension)
+	{
+		*chainEnd = &dynamicState2Features;
+		chainEnd = &dynamicState2Features.pNext;
+	}
+	if (dynamicState3Extension)
+	{
+		*chainEnd = &dynamicState3Features;
+		chainEnd = &dynamicState3Features.pNext;
+	}
+	if (deviceFeatures2.pNext != nullptr)
+	{
+		vkGetPhysicalDeviceFeatures2(mainDevice.physicalDevice, &deviceFeatures2);
+	}
+
+	optionalFeatures.extendedDynamicState = dynamicStateExtension && dynamicStateFeatures.extendedDynamicState == VK_TRUE;
+	optionalFeatures.extendedDynamicState2 = dynamicState2Extension && dynamicState2Features.extendedDynamicState2 == VK_TRUE;
+	optionalFeatures.dynamicPolygonMode = dynamicState3Extension && dynamicState3Features.extendedDynamicState3PolygonMode == VK_TRUE;
+	optionalFeatures.dynamicBlend = dynamicState3Extension && dynamicState3Features.extendedDynamicState3ColorBlendEnable == VK_TRUE
+		&& dynamicState3Features.extendedDynamicState3ColorBlendEquation == VK_TRUE && dynamicState3Features.extendedDynamicState3ColorWriteMask == VK_TRUE;
+	printf("Extended dynamic state: %s | 2: %s | 3 polygon mode: %s | 3 blend: %s\n",
+		optionalFeatures.extendedDynamicState ? "yes" : "no", optionalFeatures.extendedDynamicState2 ? "yes" : "no",
+		optionalFeatures.dynamicPolygonMode ? "yes" : "no", optionalFeatures.dynamicBlend ? "yes" : "no");
+
+	// Graphics pipeline library lets new pipelines be linked from already compiled parts instead of a full compile
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures = {};
+	pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+	VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT pipelineLibraryProperties = {};
+	pipelineLibraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+	bool pipelineLibraryExtensions = CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
+		&& CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+	if (pipelineLibraryExtensions)
+	{
+		deviceFeatures2.pNext = &pipelineLibraryFeatures;
+		vkGetPhysicalDeviceFeatures2(mainDevice.physicalDevice, &deviceFeatures2);
+
+		VkPhysicalDeviceProperties2 deviceProperties2 = {};
+		deviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		deviceProperties2.pNext = &pipelineLibraryProperties;
+		vkGetPhysicalDeviceProperties2(mainDevice.physicalDevice, &deviceProperties2);
+	}
+
+	optionalFeatures.graphicsPipelineLibrary = pipelineLibraryExtensions && pipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+	printf("Graphics pipeline library: %s | fast linking: %s\n", optionalFeatures.graphicsPipelineLibrary ? "yes" : "no",
+		pipelineLibraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE ? "yes" : "no");
+
+	// Instrumentation: per pass GPU work counters and cache hit/miss of pipeline creation
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(mainDevice.physicalDevice, &supportedFeatures);
+	optionalFeatures.pipelineStatistics = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+	optionalFeatures.pipelineCreationFeedback = CheckDeviceExtensionSupport(mainDevice.physicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+	printf("Pipeline statistics queries: %s | pipeline creation feedback: %s\n", optionalFeatures.pipelineStatistics ? "yes" : "no",
+		optionalFeatures.pipelineCreationFeedback ? "yes" : "no");
+}
+
 bool VulkanRenderer::CheckInstanceExtensionsSupport(std::vector<const char*>* checkExtensions)
 {
 	// Need to get number of extensions to create array of correct size to hold extensions
@@ -1253,7 +2606,7 @@ bool VulkanRenderer::CheckDeviceExtensionsSupport(VkPhysicalDevice device)
 		bool hasExtension = false;
 		for (const auto& extension : extensions)
 		{
-			if (strcmp(deviceExtension, extension.extensionName))
+			if (strcmp(deviceExtension, extension.extensionName) == 0)
 			{
 				hasExtension = true;
 				break;
@@ -1268,6 +2621,25 @@ bool VulkanRenderer::CheckDeviceExtensionsSupport(VkPhysicalDevice device)
 	return true;
 }
 
+bool VulkanRenderer::CheckDeviceExtensionSupport(VkPhysicalDevice device, const char* extensionName)
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+	for (const auto& extension : extensions)
+	{
+		if (strcmp(extensionName, extension.extensionName) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool VulkanRenderer::CheckValidationLayerSupport()
 {
 	// Get number of validation layers to create vector of appropriate size
@@ -1319,17 +2691,32 @@ bool VulkanRenderer::CheckDeviceSuitable(VkPhysicalDevice device)
 
 	QueueFamilyIndices indices = GetQueueFamilies(device);
 
-	bool extensionSupported = CheckDeviceExtensionsSupport(device);
+	// Frame synchronisation is built on timeline semaphores (core in Vulkan 1.2)
+	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+	deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	deviceFeatures2.pNext = &vulkan12Features;
+	if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+	{
+		vkGetPhysicalDeviceFeatures2(device, &deviceFeatures2);
+	}
+
+	bool timelineSupported = vulkan12Features.timelineSemaphore == VK_TRUE;
 
-	bool swapChainValid = false;
+	// Headless mode needs no swapchain, so neither it's extension nor a valid surface
+	bool extensionSupported = headless || CheckDeviceExtensionsSupport(device);
 
-	if (extensionSupported)
+	bool swapChainValid = headless;
+
+	if (extensionSupported && !headless)
 	{
 		SwapChainDetails swapChain = GetSwapChainDetails(device);
 		swapChainValid = swapChain.IsValid();
 	}
 
-	return indices.IsValid() && extensionSupported && swapChainValid;
+	return indices.IsValid() && timelineSupported && extensionSupported && swapChainValid;
 }
 
 QueueFamilyIndices VulkanRenderer::GetQueueFamilies(VkPhysicalDevice device)
@@ -1344,34 +2731,65 @@ QueueFamilyIndices VulkanRenderer::GetQueueFamilies(VkPhysicalDevice device)
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyList.data());
 
 	// Go throuth each queue family and chek if it has at least 1 of the required types of queue
+	// All families are checked, dedicated transfer/compute families can come after graphics one
 	int i = 0;
 	for (const auto& queueFamily : queueFamilyList)
 	{
 		// First check if queue family has a least 1 queue in that family (could have no queues)
 		// Queue can be multiple types defined through bitfield. Need to bitwise AND with VK_QUEUE_*_BIT to check if has required type
-		if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		bool hasQueues = queueFamily.queueCount > 0;
+		bool graphics = hasQueues && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+		bool compute = hasQueues && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+		bool transfer = hasQueues && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT);
+
+		if (graphics && indices.graphicsFamily < 0)
 		{
 			indices.graphicsFamily = i; // if queue family is valid, then get index;
 		}
 
-		// Check id Queue Family supports presentation
+		// Check id Queue Family supports presentation (no surface in headless mode)
 		VkBool32 presentationSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentationSupport);
+		if (!headless)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentationSupport);
+		}
 		// Check if queue is presentation type (can be both graphics and presention)
-		if (queueFamily.queueCount > 0 && presentationSupport)
+		if (hasQueues && presentationSupport && indices.presentationFamily < 0)
 		{
 			indices.presentationFamily = i;
 		}
 
-		// Check if queue family indices are in valid state, stop searchable is so
-		if (indices.IsValid())
+		// Compute without graphics runs beside rendering (async compute)
+		if (compute && !graphics && indices.computeFamily < 0)
 		{
-			break;
+			indices.computeFamily = i;
+		}
+
+		// Transfer only family is usually a DMA engine, copies don't take time from graphics or compute
+		if (transfer && !graphics && !compute && indices.transferFamily < 0)
+		{
+			indices.transferFamily = i;
 		}
 
 		i++;
 	}
 
+	// Nothing is presented in headless mode, graphics queue stands in for presentation one
+	if (headless)
+	{
+		indices.presentationFamily = indices.graphicsFamily;
+	}
+
+	// No dedicated families: compute falls back to graphics, transfer to compute (both can copy)
+	if (indices.computeFamily < 0)
+	{
+		indices.computeFamily = indices.graphicsFamily;
+	}
+	if (indices.transferFamily < 0)
+	{
+		indices.transferFamily = indices.computeFamily;
+	}
+
 	return indices;
 }
 
@@ -1432,6 +2850,15 @@ VkSurfaceFormatKHR VulkanRenderer::ChooseBestSurfaceFormat(const std::vector<VkS
 
 VkPresentModeKHR VulkanRenderer::ChooseBestPresentationMode(const std::vector<VkPresentModeKHR>& presentationModes)
 {
+	// Use mode asked for at runtime if surface has it
+	for (const auto& presentationMode : presentationModes)
+	{
+		if (presentationMode == requestedPresentMode)
+		{
+			return presentationMode;
+		}
+	}
+
 	// look for Mailbox presentation mode
 	for (const auto& presentationMode : presentationModes)
 	{
@@ -1501,22 +2928,3 @@ VkImageView VulkanRenderer::CreateImageView(VkImage image, VkFormat format, VkIm
 
 	return imageView;
 }
-
-VkShaderModule VulkanRenderer::CreateShaderModule(const std::vector<char>& code)
-{
-	// Shader Module creation information
-	VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
-	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	shaderModuleCreateInfo.codeSize = code.size();										// Size of code
-	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());		// Pointer to code (of uint32_t pointer type)
-
-	VkShaderModule shaderModule;
-	VkResult result = vkCreateShaderModule(mainDevice.logicalDevice, &shaderModuleCreateInfo, nullptr, &shaderModule);
-
-	if (result != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to create a Shader Module");
-	}
-
-	return shaderModule;
-}
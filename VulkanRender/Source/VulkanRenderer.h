@@ -8,8 +8,26 @@
 #include <vector>
 #include <set>
 #include <array>
+#include <deque>
+#include <map>
 
 #include "Mesh.h"
+#include "FramePacket.h"
+#include "CommandEncoder.h"
+#include "GpuTimeline.h"
+#include "DeletionQueue.h"
+#include "FrameReadback.h"
+#include "VideoCapture.h"
+#include "PipelineCache.h"
+#include "PipelineCompiler.h"
+#include "PipelineRegistry.h"
+#include "PipelineLibrary.h"
+#include "PipelineFeedback.h"
+#include "PipelineLayoutCache.h"
+#include "UniformRing.h"
+#include "GpuStatistics.h"
+#include "ShaderCompiler.h"
+#include "ShaderWatcher.h"
 #include "VulkanValidation.h"
 #include "Utilities.h"
 
@@ -19,19 +37,81 @@ public:
 	VulkanRenderer();
 
 	int Init(GLFWwindow* newWindow);
-	void Draw();
+
+	// No window, surface or swapchain: frames are rendered to plain images (servers, CI, software ICDs)
+	int InitHeadless(uint32_t width, uint32_t height);
+	// Record and submit one frame from packet made by simulation thread
+	void Draw(const FramePacket& packet);
+
+	// Unload mesh mid-session, it's buffer is destroyed once GPU finished frames using it (index stays valid but empty)
+	void UnloadMesh(int meshIndex);
+
+	// Queue a material pipeline for background compilation, returns index for ObjectPacket::materialIndex
+	// Until it is ready, it's objects are drawn with default pipeline (useFallback) or not drawn at all
+	int AddMaterial(const std::string& vertexShaderFile, const std::string& fragmentShaderFile, bool useFallback = true);
+
+	// Copy of a material with specialization constants set (shader variant, e.g. quality level or lighting model)
+	int AddMaterialVariant(int materialIndex, const std::vector<ShaderConstant>& constants);
+
+	// Shaders of default pipeline (GLSL if it can be compiled at runtime, precompiled SPIR-V otherwise), to base materials on
+	void GetDefaultShaderFiles(std::string& vertexShaderFile, std::string& fragmentShaderFile);
+
+	// Number of frames CPU may record ahead of GPU (1 = lowest latency, more = more throughput)
+	void SetFramesInFlight(int count);
+
+	// Block until GPU finished every submitted frame
+	void WaitForFrames();
+
+	// Copy every frameInterval-th frame back to CPU, callback gets pixels on a worker thread (nullptr callback stops it)
+	bool SetReadback(const ReadbackCallback& callback, int frameInterval = 1);
+
+	// Record every frame to a Y4M file (YUV 4:2:0 converted on GPU), stops on its own if window size changes
+	bool StartVideoCapture(const std::string& fileName, int frameRate);
+	void StopVideoCapture();
+
+	int GetFramesInFlight();
+	FramePacingStats GetFramePacingStats();
+
+	// Pipeline statistics of latest measured frame (invalid if device has no pipeline statistics queries)
+	GpuFrameStatistics GetGpuStatistics();
+	// Print GPU statistics of every measured frame
+	void SetGpuStatisticsDump(bool enable);
+	bool GetGpuStatisticsDump();
+	// Pipeline cache hits and driver creation time of every graphics pipeline created so far
+	PipelineCreationStats GetPipelineCreationStats();
+	// SPIR-V optimizer stage for shaders loaded from now on (set before Init to affect all), and what it did so far
+	void SetShaderOptimization(bool enable);
+	ShaderCompilerStats GetShaderCompilerStats();
+
+	// Presentation policy (FIFO, FIFO_RELAXED, MAILBOX, IMMEDIATE), swapchain is rebuilt before next draw
+	bool SetPresentMode(VkPresentModeKHR mode);
+	VkPresentModeKHR GetPresentMode();
+	PresentLatencyStats GetPresentLatencyStats(VkPresentModeKHR mode);
+
+	// Block until last frame reached the screen, call right before taking the state next frame is drawn from (newest frame packet),
+	// so that state is as fresh as possible when frame is recorded
+	void WaitForPresent();
 	void Cleanup();
 
 	~VulkanRenderer();
 
 private:
 	// Scenes Objects
-	Mesh firstMesh;
+	std::vector<Mesh> meshList;			// Indexed by ObjectPacket::meshIndex
 
 
 	GLFWwindow* window = nullptr;
+	bool headless = false;						// Render to offscreen images instead of swapchain
 
 	int currentFrame = 0;
+	uint64_t frameCount = 0;				// Frames submitted so far
+	int framesInFlight = DEFAULT_FRAME_DRAWS;
+
+	bool framebufferResized = false;		// Window framebuffer changed size since last present
+	bool swapChainOutdated = false;			// Swapchain has to be recreated before next draw
+
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;				// Mode of current swapchain
+	VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;	// Preferred mode, used if surface supports it
 
 	// Vulkan components
 	// - Main
@@ -44,22 +124,90 @@ private:
 		VkDevice logicalDevice;
 	} mainDevice;
 
+	// Optional device features, enabled only if physical device supports them
+	struct
+	{
+		bool presentWait = false;			// VK_KHR_present_id + VK_KHR_present_wait
+		bool extendedDynamicState = false;	// VK_EXT_extended_dynamic_state: cull mode, front face, topology
+		bool extendedDynamicState2 = false;	// VK_EXT_extended_dynamic_state2: primitive restart
+		bool dynamicPolygonMode = false;	// VK_EXT_extended_dynamic_state3: polygon mode
+		bool dynamicBlend = false;			// VK_EXT_extended_dynamic_state3: blend enable, equation and write mask
+		bool graphicsPipelineLibrary = false;	// VK_KHR_pipeline_library + VK_EXT_graphics_pipeline_library: pipelines linked from parts
+		bool pipelineStatistics = false;	// pipelineStatisticsQuery device feature
+		bool pipelineCreationFeedback = false;	// VK_EXT_pipeline_creation_feedback
+	} optionalFeatures;
+
+	std::vector<const char*> enabledDeviceExtensions;
+	PFN_vkWaitForPresentKHR fpWaitForPresentKHR = nullptr;
+	DynamicStateFunctions dynamicStateFunctions;
+
 	VkQueue graphicsQueue;
 	VkQueue presentationQueue;
+	VkQueue transferQueue;
+	VkQueue computeQueue;
 	VkSurfaceKHR surface;
-	VkSwapchainKHR swapChain;
+	VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 	std::vector<SwapChainImage> swapChainImages;
 	std::vector<VkFramebuffer>	swapChainFrameBuffers;
 	std::vector<VkCommandBuffer> commandBuffers;
 
+	bool swapChainTransferSrc = false;			// Swapchain images can be copied from (needed for readback)
+
+	// - Readback
+	FrameReadback frameReadback;
+	ReadbackCallback readbackCallback;
+	int readbackInterval = 1;
+	int recordedReadbackSlot = -1;				// Readback slot copied to by command buffer just recorded (-1 = none)
+
+	// - GPU statistics
+	GpuStatistics gpuStatistics;
+	bool gpuStatisticsDump = false;
+	int recordedStatisticsSlot = -1;			// Statistics slot queried by command buffer just recorded (-1 = none)
+
+	// - Scene uniforms
+	UniformRing sceneUniforms;					// One slice per frame slot, bound with dynamic offset of current frame
+
+	// - Video capture
+	VideoCapture videoCapture;
+	int recordedCaptureSlot = -1;				// Capture slot converted to by command buffer just recorded (-1 = none)
+
+	// - Headless
+	std::vector<VkDeviceMemory> offscreenImageMemory;	// Memory of offscreen images (in swapChainImages)
+	uint32_t nextOffscreenImage = 0;
+
 	// - Pipeline
-	VkPipeline graphicsPipeline;
-	VkPipelineLayout pipelineLayout;
+	PipelineCache pipelineCache;
+	PipelineCompiler pipelineCompiler;
+	PipelineRegistry pipelineRegistry;			// Owns all graphics pipelines
+	PipelineLibrary pipelineLibrary;			// Shared pipeline parts, only used with graphics pipeline library
+	PipelineFeedback pipelineFeedback;			// Creation feedback of every graphics pipeline
+	ShaderModuleCache shaderModules;			// Shader modules shared by all pipelines, keyed by SPIR-V content
+	ShaderCompiler shaderCompiler;				// Runtime GLSL compiler (only with USE_SHADERC)
+	ShaderWatcher shaderWatcher;				// Edited shaders are reloaded in to live pipelines
+	PipelineHandle defaultPipeline;				// Default pipeline, fallback for materials still compiling
+	PipelineDescription defaultPipelineDescription;
+	PipelineLayoutCache pipelineLayouts;		// Layouts derived from shader reflection, shared by compatible pipelines
+	PipelineLayoutInfo defaultPipelineLayout;
 	VkRenderPass renderPass;
 
+	// - Materials
+	struct Material
+	{
+		PipelineDescription description;
+		bool useFallback = true;
+		PipelineHandle pipeline;				// Shared with materials of same description
+		PipelineLayoutInfo layout;				// Looked up once pipeline is ready (shader modules are loaded by then)
+	};
+	std::vector<Material> materials;
+
 	// - Pools
 	VkCommandPool graphicsCommandPool;
 
+	// - Submission
+	ImmediateSubmitter immediateSubmitter;		// One-shot work outside frame loop on graphics queue (transitions, ownership acquires)
+	ImmediateSubmitter transferSubmitter;		// Uploads, on dedicated transfer queue if device has one
+	ImmediateSubmitter computeSubmitter;		// Async compute, on dedicated compute queue if device has one
+
 	// - Utility
 	VkFormat swapChainImageFormat;
 	VkExtent2D swapChainExtent;
@@ -67,32 +215,84 @@ private:
 	// - Synchronisation
 	std::vector<VkSemaphore> imageAvaible;
 	std::vector<VkSemaphore> renderFinished;
-	std::vector<VkFence> drawFences;
+	GpuTimeline frameTimeline;					// GPU timeline of graphics queue (frames and one-shot work)
+	std::vector<uint64_t> frameTimelineValues;	// Timeline value each frame slot signals when its frame is finished
+	std::vector<uint64_t> imageTimelineValues;	// Timeline value of last frame that rendered to each swapchain image
+	GpuTimeline transferTimeline;				// GPU timeline of transfer queue
+	GpuTimeline computeTimeline;				// GPU timeline of compute queue
+	DeletionQueue deletionQueue;				// Objects destroyed once all queues passed their last use
+
+	// - Frame pacing
+	FramePacingStats framePacing;				// Stats of current report interval
+	FramePacingStats lastFramePacing;			// Stats of last finished report interval
+	std::chrono::high_resolution_clock::time_point lastDrawTime;
+	std::chrono::high_resolution_clock::time_point lastReportTime;
+
+	// - Present latency
+	uint64_t lastPresentId = 0;								// Id of last presented frame (ids never restart)
+	uint64_t swapChainFirstPresentId = 1;					// First id presented with current swapchain
+	std::deque<PresentTiming> pendingPresents;				// Presented frames not measured yet, oldest first
+	std::map<VkPresentModeKHR, PresentLatencyStats> presentLatency;
+
+	// - Statistics
+	EncoderStats recordStats;			// Binds issued/skipped while recording command buffers (current report interval)
 
 	// Vulkan functions
+	int InitVulkan();
+
 	// - Create functions
 	void CreateInstance();
 	void CreateDebugCallback();
 	void CreateLogicalDevice();
+	void CreateImmediateSubmitters();
 	void CreateSurface();
 	void CreateSwapChain();
+	void CreateOffscreenTargets();
 	void CreateRenderPass();
 	void CreateGraphicsPipeline();
+	PipelineDescription MakePipelineDescription(const std::string& vertexShaderFile, const std::string& fragmentShaderFile);
+	VkPipeline BuildGraphicsPipeline(VkPipelineCache cache, const PipelineDescription& description, PipelineBuildPass pass);
+	void ReloadChangedShaders();
+	void RefreshPipelineLayouts(const std::vector<PipelineHandle>& reloadedPipelines);
+	void SetDynamicState(CommandEncoder& encoder, const PipelineDescription& description);
+	VkPipeline GetMaterialPipeline(int materialIndex, const PipelineLayoutInfo*& layout);
+	void PushObjectConstants(CommandEncoder& encoder, const PipelineLayoutInfo* layout, const ObjectPacket& object);
 	void CreateFrameBuffers();
 	void CreateCommandPool();
 	void CreateCommandBuffers();
 	void CreateSynchronisation();
+	void CreateFrameSlots();
+
+	// - Recreate functions
+	bool RecreateSwapChain();
+	static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
 
 	// - Record Functions
-	void RecordCommands();
+	void RecordCommands(uint32_t imageIndex, const FramePacket& packet);
+	void CreateSceneUniforms();
+	void UpdateSceneUniforms(const FramePacket& packet);
+
+	// - Destroy functions
+	void DestroyFrameSlots();
+
+	// - Report functions
+	void ReportFramePacing();
+	void ReportPresentLatency();
+	void ReportShaderCompilation();
+
+	// - Present latency functions
+	bool IsPresented(const PresentTiming& frame, uint64_t timeout);
+	void CollectPresentTimings();
 
 	// - Get functions
 	void GetPhysicalDevice();
+	void GetOptionalFeatures();
 
 	// - Support functions
 	// -- Checker Functions
 	bool CheckInstanceExtensionsSupport(std::vector<const char*>* checkExtensions);
 	bool CheckDeviceExtensionsSupport(VkPhysicalDevice device);
+	bool CheckDeviceExtensionSupport(VkPhysicalDevice device, const char* extensionName);
 	bool CheckValidationLayerSupport();
 	bool CheckDeviceSuitable(VkPhysicalDevice device);
 
@@ -107,5 +307,4 @@ private:
 
 	// --Create functions
 	VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-	VkShaderModule CreateShaderModule(const std::vector<char>& code);
 };
\ No newline at end of file
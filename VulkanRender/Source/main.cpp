@@ -6,9 +6,13 @@
 #include <vector>
 
 #include "VulkanRenderer.h"
+#include "FramePacket.h"
+#include "Simulation.h"
 
 GLFWwindow* window = nullptr;
 VulkanRenderer vulkanRenderer;
+FramePacketBuffer framePackets;			// Simulation thread -> render (main) thread
+Simulation simulation;
 
 void initWindow(std::string wName, const int width = 800, const int height = 600)
 {
@@ -17,13 +21,158 @@ void initWindow(std::string wName, const int width = 800, const int height = 600
 
 	// Set GLFW not work with OpenGL
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
 	window = glfwCreateWindow(width, height, wName.c_str(), nullptr, nullptr);
 }
 
-int main()
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+	if (action != GLFW_PRESS)
+	{
+		return;
+	}
+
+	// Switch presentation mode live (swapchain is rebuilt on next draw)
+	switch (key)
+	{
+	case GLFW_KEY_1: vulkanRenderer.SetPresentMode(VK_PRESENT_MODE_FIFO_KHR); break;
+	case GLFW_KEY_2: vulkanRenderer.SetPresentMode(VK_PRESENT_MODE_FIFO_RELAXED_KHR); break;
+	case GLFW_KEY_3: vulkanRenderer.SetPresentMode(VK_PRESENT_MODE_MAILBOX_KHR); break;
+	case GLFW_KEY_4: vulkanRenderer.SetPresentMode(VK_PRESENT_MODE_IMMEDIATE_KHR); break;
+	case GLFW_KEY_G: vulkanRenderer.SetGpuStatisticsDump(!vulkanRenderer.GetGpuStatisticsDump()); break;
+	case GLFW_KEY_U: vulkanRenderer.UnloadMesh(0); break;
+	}
+}
+
+// Write every interval-th frame to a PPM file (written on readback worker thread)
+void startCapture(int interval)
+{
+	if (interval <= 0)
+	{
+		return;
+	}
+
+	vulkanRenderer.SetReadback(
+		[](const ReadbackImage& image)
+		{
+			char fileName[64];
+			snprintf(fileName, sizeof(fileName), "capture_%06llu.ppm", (unsigned long long)image.frameNumber);
+			FrameReadback::WritePPM(fileName, image);
+		}, interval);
+}
+
+// Materials of scene objects, pipelines compile in background (objects use default pipeline, or are skipped, until then)
+void addMaterials()
+{
+	std::string vertexShaderFile;
+	std::string fragmentShaderFile;
+	vulkanRenderer.GetDefaultShaderFiles(vertexShaderFile, fragmentShaderFile);
+
+	// Same state as default pipeline, so registry hands out that pipeline instead of compiling a second one
+	int baseMaterial = vulkanRenderer.AddMaterial(vertexShaderFile, fragmentShaderFile);
+
+	// Shader variant: only GRAYSCALE constant differs, so it is a pipeline of it's own (drawn with default one until compiled)
+	int grayscaleMaterial = vulkanRenderer.AddMaterialVariant(baseMaterial, { ShaderConstant::Bool(VK_SHADER_STAGE_FRAGMENT_BIT, GRAYSCALE_CONSTANT_ID, true) });
+
+	simulation.SetObjectMaterials({ baseMaterial, grayscaleMaterial });
+}
+
+// Render given number of frames offscreen as fast as possible and report throughput
+int runHeadless(int frameCount, int framesInFlight, int captureInterval, const std::string& recordFile, int recordFrameRate)
+{
+	if (vulkanRenderer.InitHeadless(1280, 720) == EXIT_FAILURE)
+	{
+		return EXIT_FAILURE;
+	}
+
+	vulkanRenderer.SetFramesInFlight(framesInFlight);
+	addMaterials();
+	startCapture(captureInterval);
+	if (!recordFile.empty())
+	{
+		// Nothing paces headless frames, stream is played back at the given rate (default 60)
+		vulkanRenderer.StartVideoCapture(recordFile, recordFrameRate > 0 ? recordFrameRate : 60);
+	}
+	simulation.Start(&framePackets);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < frameCount; i++)
+	{
+		const FramePacket* packet = framePackets.AcquireLatest();
+		if (packet != nullptr)
+		{
+			vulkanRenderer.Draw(*packet);
+		}
+	}
+	vulkanRenderer.WaitForFrames();
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	printf("Headless: %i frames in %.3f s (%.1f FPS)\n", frameCount, seconds, seconds > 0.0 ? frameCount / seconds : 0.0);
+
+	simulation.Stop();
+	vulkanRenderer.Cleanup();
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	// Read command line settings
+	int framesInFlight = DEFAULT_FRAME_DRAWS;
+	bool lowLatency = false;
+	bool headless = false;
+	int headlessFrames = 1000;
+	int captureInterval = 0;
+	std::string recordFile;
+	int recordFrameRate = 0;			// 0 = refresh rate of display (60 in headless mode)
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--frames-in-flight" && i + 1 < argc)
+		{
+			framesInFlight = std::atoi(argv[++i]);
+		}
+		else if (argument == "--low-latency")
+		{
+			lowLatency = true;
+		}
+		else if (argument == "--headless")
+		{
+			headless = true;
+		}
+		else if (argument == "--frames" && i + 1 < argc)
+		{
+			headlessFrames = std::atoi(argv[++i]);
+		}
+		else if (argument == "--capture" && i + 1 < argc)
+		{
+			captureInterval = std::atoi(argv[++i]);
+		}
+		else if (argument == "--record" && i + 1 < argc)
+		{
+			recordFile = argv[++i];
+		}
+		else if (argument == "--record-fps" && i + 1 < argc)
+		{
+			recordFrameRate = std::atoi(argv[++i]);
+		}
+		else if (argument == "--gpu-stats")
+		{
+			vulkanRenderer.SetGpuStatisticsDump(true);
+		}
+		else if (argument == "--no-shader-opt")
+		{
+			vulkanRenderer.SetShaderOptimization(false);
+		}
+	}
+
+	// No window at all, GLFW is not even initialised
+	if (headless)
+	{
+		return runHeadless(headlessFrames, framesInFlight, captureInterval, recordFile, recordFrameRate);
+	}
+
 	// Create window
 	initWindow("My Vulkan app");
 
@@ -33,13 +182,53 @@ int main()
 		return EXIT_FAILURE;
 	}
 
+	// Trade latency (fewer) against throughput (more)
+	vulkanRenderer.SetFramesInFlight(framesInFlight);
+	addMaterials();
+	startCapture(captureInterval);
+
+	// Y4M video of the session, every rendered frame is one video frame
+	// Plays at right speed when frames are paced to display (FIFO), otherwise pass the rate with --record-fps
+	if (!recordFile.empty())
+	{
+		if (recordFrameRate <= 0)
+		{
+			const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+			recordFrameRate = videoMode != nullptr && videoMode->refreshRate > 0 ? videoMode->refreshRate : 60;
+		}
+		vulkanRenderer.StartVideoCapture(recordFile, recordFrameRate);
+	}
+
+	// Keys 1-4: FIFO, FIFO_RELAXED, MAILBOX, IMMEDIATE, G: toggle per frame GPU statistics dump
+	// U: unload scene mesh mid-session (objects using it stop drawing, buffer goes once GPU is done with it)
+	glfwSetKeyCallback(window, keyCallback);
+
+	// Update work runs on its own thread, main thread only handles window events and rendering
+	simulation.Start(&framePackets);
+
 	// Loop until close
 	while (!glfwWindowShouldClose(window))
 	{
 		glfwPollEvents();
-		vulkanRenderer.Draw();
+
+		// Low latency loop: wait until last frame is on screen, then take simulation state for the next one
+		// Scene is not input driven, so the newest frame packet (not window events) is what gets fresher by waiting
+		if (lowLatency)
+		{
+			vulkanRenderer.WaitForPresent();
+		}
+
+		// Draw newest finished packet (same one again if simulation has not made a new one yet)
+		const FramePacket* packet = framePackets.AcquireLatest();
+		if (packet != nullptr)
+		{
+			vulkanRenderer.Draw(*packet);
+		}
 	}
 
+	simulation.Stop();
+	printf("Frame packets dropped (simulation ahead of render): %llu\n", (unsigned long long)framePackets.GetDroppedCount());
+
 	// Clear Vulkan
 	vulkanRenderer.Cleanup();
 